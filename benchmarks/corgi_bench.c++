@@ -0,0 +1,311 @@
+/// Micro-benchmarks of corgi core operations
+//
+// Usage (one node):
+//
+//   mpirun -np 4 ./corgi_bench --dims 2,3 --tiles 1024,16384 --reps 20 --output bench.json
+//
+// Every operation is timed --reps times on all ranks; the time of one
+// repetition is the maximum over ranks. Results (min/median/mean and
+// time per element) are written by rank 0 as JSON.
+
+#include <vector>
+#include <string>
+#include <sstream>
+#include <fstream>
+#include <iostream>
+#include <algorithm>
+#include <numeric>
+#include <functional>
+#include <stdexcept>
+#include <cmath>
+#include <cstdint>
+#include <thread>
+
+#include "corgi/corgi.h"
+
+#include <mpi4cpp/mpi.h>
+
+#ifndef CORGI_VERSION
+#define CORGI_VERSION "unknown"
+#endif
+
+
+namespace {
+
+struct options {
+  std::vector<size_t> dims  = {1, 2, 3};
+  std::vector<size_t> tiles = {1024, 4096};
+  size_t reps = 10;
+  std::string output;
+};
+
+struct result {
+  std::string name;
+  size_t dims;
+  std::vector<size_t> lengths;
+  size_t elements;           ///< items processed per repetition
+  std::vector<double> times; ///< max over ranks of each repetition (s)
+};
+
+
+std::vector<size_t> parse_list(const std::string& arg)
+{
+  std::vector<size_t> ret;
+  std::stringstream ss(arg);
+  std::string item;
+  while(std::getline(ss, item, ',')) ret.push_back( std::stoul(item) );
+  return ret;
+}
+
+options parse_args(int argc, char** argv)
+{
+  options opt;
+  for(int i=1; i<argc; i++) {
+    const std::string arg = argv[i];
+    auto value = [&]() -> std::string {
+      if(i+1 >= argc) throw std::invalid_argument("missing value for " + arg);
+      return argv[++i];
+    };
+
+    if     (arg == "--dims")   opt.dims   = parse_list(value());
+    else if(arg == "--tiles")  opt.tiles  = parse_list(value());
+    else if(arg == "--reps")   opt.reps   = std::stoul(value());
+    else if(arg == "--output") opt.output = value();
+    else throw std::invalid_argument("unknown argument " + arg);
+  }
+
+  for(auto d : opt.dims) if(d < 1 || d > 3) throw std::invalid_argument("dims must be 1, 2, or 3");
+  if(opt.reps < 1) throw std::invalid_argument("reps must be positive");
+  return opt;
+}
+
+
+/// keep results of benchmarked calls alive
+volatile uint64_t sink = 0;
+
+
+/// time f reps times; each repetition starts together on all ranks
+std::vector<double> measure(size_t reps, const std::function<void()>& f,
+    const std::function<void()>& setup = nullptr)
+{
+  std::vector<double> times(reps);
+  for(size_t r=0; r<reps; r++) {
+    if(setup) setup();
+    MPI_Barrier(MPI_COMM_WORLD);
+    double t0 = MPI_Wtime();
+    f();
+    times[r] = MPI_Wtime() - t0;
+  }
+
+  std::vector<double> tmax(reps);
+  MPI_Allreduce(times.data(), tmax.data(), static_cast<int>(reps), MPI_DOUBLE, MPI_MAX, MPI_COMM_WORLD);
+  return tmax;
+}
+
+
+template<std::size_t D>
+std::unique_ptr<corgi::Grid<D>> make_grid(size_t L)
+{
+  if constexpr (D == 1) return std::make_unique<corgi::Grid<1>>(L);
+  if constexpr (D == 2) return std::make_unique<corgi::Grid<2>>(L, L);
+  if constexpr (D == 3) return std::make_unique<corgi::Grid<3>>(L, L, L);
+}
+
+
+/// slab decomposition along the first axis
+template<std::size_t D>
+int slab_owner(const corgi::internals::tuple_of<D, size_t>& ind, size_t L, int nranks)
+{
+  return static_cast<int>( std::get<0>(ind)*nranks/L );
+}
+
+
+template<std::size_t D>
+void run_suite(size_t ntiles, const options& opt, std::vector<result>& results)
+{
+  int rank = 0, nranks = 1;
+  MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+  MPI_Comm_size(MPI_COMM_WORLD, &nranks);
+
+  // tiles per dimension; every rank gets at least one slab
+  auto L = static_cast<size_t>( std::lround( std::pow(static_cast<double>(ntiles), 1.0/D) ) );
+  L = std::max<size_t>(L, std::max(3, nranks));
+
+  auto gridptr = make_grid<D>(L);
+  auto& grid = *gridptr;
+
+  std::array<size_t, D> lens;
+  lens.fill(L);
+  uint64_t ncells = 1;
+  for(auto l : lens) ncells *= l;
+
+  // ownership and local tiles
+  std::vector<int> owners(ncells);
+  for(uint64_t cid=0; cid<ncells; cid++) {
+    owners[cid] = slab_owner<D>( grid.id2index(cid, lens), L, nranks );
+  }
+  grid.py_set_mpi_grid_data(owners);
+
+  std::vector<double> work(ncells, 1.0);
+  grid.py_set_work_grid_data(work);
+
+  for(uint64_t cid=0; cid<ncells; cid++) {
+    if(owners[cid] != rank) continue;
+    auto tile = std::make_shared<corgi::Tile<D>>();
+    grid.add_tile(tile, grid.id2index(cid, lens));
+  }
+
+  // virtual tiles
+  grid.analyze_boundaries();
+  grid.send_tiles();
+  grid.recv_tiles();
+  MPI_Barrier(MPI_COMM_WORLD);
+
+  auto add = [&](const std::string& name, size_t elements, std::vector<double> times) {
+    results.push_back({name, D, std::vector<size_t>(lens.begin(), lens.end()), elements, std::move(times)});
+  };
+
+  const size_t reps = opt.reps;
+  const auto local  = grid.get_local_tiles();
+
+  //--------------------------------------------------
+  add("id2index+id", ncells, measure(reps, [&]() {
+    uint64_t s = 0;
+    for(uint64_t cid=0; cid<ncells; cid++) s += grid.id( grid.id2index(cid, lens) );
+    sink = s;
+  }));
+
+  add("Tile::nhood", local.size(), measure(reps, [&]() {
+    uint64_t s = 0;
+    for(auto cid : local) s += grid.get_tile(cid).nhood().size();
+    sink = s;
+  }));
+
+  add("analyze_boundaries", local.size(), measure(reps, [&]() {
+    grid.analyze_boundaries();
+  }));
+
+  add("get_local_tiles", local.size(), measure(reps, [&]() {
+    sink = grid.get_local_tiles().size();
+  }));
+
+  add("get_virtuals", local.size(), measure(reps, [&]() {
+    sink = grid.get_virtuals().size();
+  }));
+
+  add("get_boundary_tiles", local.size(), measure(reps, [&]() {
+    sink = grid.get_boundary_tiles().size();
+  }));
+
+  add("sparse_grid::operator()", ncells, measure(reps, [&]() {
+    int64_t s = 0;
+    for(uint64_t cid=0; cid<ncells; cid++) {
+      s += std::apply([&](auto... i) { return grid.py_get_mpi_grid(i...); }, grid.id2index(cid, lens));
+    }
+    sink = static_cast<uint64_t>(s);
+  }));
+
+  add("sparse_grid::serialize", ncells, measure(reps, [&]() {
+    sink = grid.py_get_mpi_grid_data().size();
+  }));
+
+  add("sparse_grid::deserialize", ncells, measure(reps, [&]() {
+    grid.py_set_mpi_grid_data(owners);
+  }));
+
+  add("allgather_work_grid", ncells, measure(reps, [&]() {
+    grid.allgather_work_grid();
+  }));
+
+  // council changes ownership; restore the initial state before every call
+  add("adoption_council2", ncells, measure(reps, [&]() {
+    grid.adoption_council2();
+  }, [&]() {
+    grid.py_set_mpi_grid_data(owners);
+    for(auto& elem : grid.tiles) {
+      elem.second->communication.owner = owners[elem.first];
+    }
+  }));
+
+  grid.py_set_mpi_grid_data(owners);
+}
+
+
+double median(std::vector<double> v)
+{
+  std::sort(v.begin(), v.end());
+  const size_t n = v.size();
+  return n % 2 == 1 ? v[n/2] : 0.5*(v[n/2 - 1] + v[n/2]);
+}
+
+void write_json(std::ostream& os, const options& opt, const std::vector<result>& results, int nranks)
+{
+  os.precision(9);
+  os << "{\n";
+  os << "  \"benchmark\": \"corgi_bench\",\n";
+  os << "  \"corgi_version\": \"" << CORGI_VERSION << "\",\n";
+  os << "  \"ranks\": " << nranks << ",\n";
+  os << "  \"hardware_concurrency\": " << std::thread::hardware_concurrency() << ",\n";
+  os << "  \"reps\": " << opt.reps << ",\n";
+  os << "  \"results\": [\n";
+
+  for(size_t n=0; n<results.size(); n++) {
+    const auto& r = results[n];
+    const double mean = std::accumulate(r.times.begin(), r.times.end(), 0.0)/r.times.size();
+    const double med  = median(r.times);
+
+    os << "    {\"name\": \"" << r.name << "\", \"dims\": " << r.dims << ", \"lengths\": [";
+    for(size_t i=0; i<r.lengths.size(); i++) os << (i ? ", " : "") << r.lengths[i];
+    os << "], \"elements\": " << r.elements
+       << ", \"min\": "    << *std::min_element(r.times.begin(), r.times.end())
+       << ", \"median\": " << med
+       << ", \"mean\": "   << mean
+       << ", \"max\": "    << *std::max_element(r.times.begin(), r.times.end())
+       << ", \"median_per_element\": " << (r.elements > 0 ? med/r.elements : 0.0)
+       << "}" << (n + 1 < results.size() ? "," : "") << "\n";
+  }
+
+  os << "  ]\n";
+  os << "}\n";
+}
+
+} // end of anonymous namespace
+
+
+int main(int argc, char** argv)
+{
+  mpi4cpp::mpi::environment env;
+
+  int rank = 0, nranks = 1;
+  MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+  MPI_Comm_size(MPI_COMM_WORLD, &nranks);
+
+  options opt;
+  try {
+    opt = parse_args(argc, argv);
+  } catch(std::exception& e) {
+    if(rank == 0) std::cerr << "corgi_bench: " << e.what() << "\n"
+      << "usage: corgi_bench [--dims 1,2,3] [--tiles N,...] [--reps N] [--output file.json]\n";
+    return 1;
+  }
+
+  std::vector<result> results;
+  for(auto d : opt.dims) {
+    for(auto n : opt.tiles) {
+      if(d == 1) run_suite<1>(n, opt, results);
+      if(d == 2) run_suite<2>(n, opt, results);
+      if(d == 3) run_suite<3>(n, opt, results);
+    }
+  }
+
+  if(rank == 0) {
+    if(opt.output.empty()) {
+      write_json(std::cout, opt, results, nranks);
+    } else {
+      std::ofstream f(opt.output);
+      write_json(f, opt, results, nranks);
+    }
+  }
+
+  return 0;
+}
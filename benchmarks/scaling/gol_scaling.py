@@ -0,0 +1,179 @@
+"""Timed game-of-life run for scaling studies.
+
+    mpirun -np 4 python3 gol_scaling.py --Nx 32 --Ny 32 --mesh 64 --steps 100
+
+Each step is: halo exchange of mode 0 (send_recv + wait), copy of the
+received halos into the local meshes (unpack), and solve + cycle
+(compute). With --strips only the halo strips read by each destination
+are packed and sent, and with --codec they are also bit-packed. The grid
+packs inside send_data; that time (from the codec statistics) is taken
+out of send_recv and reported as pack. Without --strips/--codec the
+meshes are sent as they are and pack stays 0. With --balance-every K the
+ownership is rebalanced every K steps with adoption_council2 (balance);
+the virtual copies are first refreshed with whole meshes so that adopted
+tiles continue from the current generation. With --bits the tiles store
+bit-packed meshes and are solved with the bit-sliced BitSolver. With
+--halo H the meshes have H wide halos and every step advances H
+generations per exchange. With --activity tiles that did not change are
+skipped in the compute and the exchange (exchange_activity is part of
+send_recv).
+"""
+
+import numpy as np
+
+import harness
+from harness import MPI
+
+import pycorgi
+import pyca
+
+
+def new_tile(args, mesh=None):
+    if mesh is None:
+        # empty buffers are constructed in place
+        tile = pyca.BitTile() if args.bits else pyca.Tile()
+        for _ in range(2):
+            if args.bits:
+                tile.emplace_data(args.mesh, args.mesh)
+            else:
+                tile.emplace_data(args.mesh, args.mesh, args.halo)
+        return tile
+    if args.bits:
+        tile = pyca.BitTile()
+        mesh = pyca.BitMesh(mesh)
+    else:
+        tile = pyca.Tile()
+    tile.add_data(mesh)
+    tile.add_data(mesh)
+    return tile
+
+
+def load_tiles(grid, args):
+    rng = np.random.default_rng(grid.rank())
+    for i in range(grid.get_Nx()):
+        for j in range(grid.get_Ny()):
+            if grid.get_mpi_grid(i, j) != grid.rank():
+                continue
+            h = args.halo
+            mesh = pyca.Mesh(args.mesh, args.mesh, h)
+            cells = np.asarray(mesh)
+            cells[h:-h, h:-h] = rng.random((args.mesh, args.mesh)) < args.density
+            grid.add_tile(new_tile(args, mesh), (i, j))
+
+
+def initialize_virtuals(grid, args):
+    """Replace the metadata-only virtual tiles with gol tiles."""
+    for cid in grid.get_virtual_tiles():
+        orig = grid.get_tile(cid)
+        if isinstance(orig, (pyca.Tile, pyca.BitTile)):
+            continue
+        # replace_tile keeps the owner; add_tile would claim the tile
+        grid.replace_tile(new_tile(args), orig.index)
+
+
+def update_topology(grid, args):
+    grid.analyze_boundaries()
+    grid.send_tiles()
+    grid.recv_tiles()
+    initialize_virtuals(grid, args)
+
+
+# raw mode that sends whole tiles; codecs are only set for mode 0
+MIGRATE = 1
+
+
+def rebalance(grid, args):
+    # adopted tiles become local from their virtual copies, which are a
+    # generation behind and, with --strips/--codec/--activity, only partly
+    # up to date; refresh them with the full meshes first (activity only
+    # skips tiles in mode 0).
+    grid.recv_data(MIGRATE)
+    grid.send_data(MIGRATE)
+    grid.wait_data(MIGRATE)
+
+    grid.adoption_council2()
+    grid.erase_virtuals()
+    update_topology(grid, args)
+
+
+def step(grid, sol, timer, args, lap):
+    packed = grid.get_codec(0) is not None
+    encode0 = grid.get_codec_stats(0).encode_time if packed else 0.0
+    with timer("send_recv"):
+        if args.activity:
+            grid.exchange_activity(0)
+        grid.recv_data(0)
+        grid.send_data(0)
+    if packed:
+        timer.split("send_recv", "pack", grid.get_codec_stats(0).encode_time - encode0)
+    with timer("wait"):
+        grid.wait_data(0)
+    with timer("unpack"):
+        pyca.update_boundaries(grid)
+    with timer("compute"):
+        if args.bits:
+            sol.solve_all(grid)
+        else:
+            sol.solve_all(grid, args.halo)
+        pyca.cycle(grid)
+    if args.balance_every > 0 and lap % args.balance_every == 0:
+        with timer("balance"):
+            rebalance(grid, args)
+
+
+if __name__ == "__main__":
+    p = harness.parser("game-of-life scaling driver")
+    p.add_argument("--density", type=float, default=0.3, help="initial fraction of live cells")
+    p.add_argument("--strips", action="store_true", help="send only the halo strips")
+    p.add_argument("--codec", action="store_true", help="send bit-packed halo strips")
+    p.add_argument("--bits", action="store_true", help="bit-packed meshes and BitSolver")
+    p.add_argument("--balance-every", type=int, default=0, help="rebalance every K steps (0 = never)")
+    p.add_argument("--halo", type=int, default=1, help="halo width; generations per exchange")
+    p.add_argument("--activity", action="store_true", help="skip tiles that did not change")
+    args = p.parse_args()
+    if args.bits and args.halo != 1:
+        p.error("--bits supports only --halo 1")
+
+    grid = pycorgi.twoD.Grid(args.Nx, args.Ny)
+    grid.set_grid_lims(0.0, 1.0, 0.0, 1.0)
+    grid.set_num_threads(args.threads)
+    if args.codec:
+        grid.set_codec(0, pycorgi.BitpackCodec())
+    elif args.strips:
+        grid.set_codec(0, pycorgi.CopyCodec())
+
+    harness.load_mpi_grid(grid, args.decomposition)
+    load_tiles(grid, args)
+    update_topology(grid, args)
+
+    sol = pyca.BitSolver() if args.bits else pyca.Solver()
+    sol.track_activity = args.activity
+
+    warm = harness.PhaseTimer()
+    for lap in range(args.warmup):
+        step(grid, sol, warm, args, lap + 1)
+    grid.reset_codec_stats()
+
+    if args.trace:
+        grid.start_trace()
+
+    timer = harness.PhaseTimer()
+    MPI.COMM_WORLD.barrier()
+    t0 = MPI.Wtime()
+    for lap in range(1, args.steps + 1):
+        step(grid, sol, timer, args, lap)
+    wall = MPI.Wtime() - t0
+
+    if args.trace:
+        grid.write_trace(args.trace)
+
+    halo = grid.make_comm_report(0)
+    extra = {"codec": args.codec, "strips": args.strips or args.codec, "bits": args.bits, "halo": args.halo, "activity": args.activity, "balance_every": args.balance_every,
+             "halo_bytes": halo.total_bytes(), "max_rank_halo_bytes": halo.max_rank_bytes()}
+    if args.codec:
+        extra["codec_ratio"] = grid.get_codec_stats(0).ratio()
+    if args.activity:
+        extra["active_tiles"] = len(grid.get_active_tiles())
+    if args.codec or args.strips:
+        extra["strip_bytes"] = grid.get_codec_stats(0).raw_bytes_sent
+    harness.report("game-of-life", args, grid, timer, wall, extra)
@@ -0,0 +1,110 @@
+"""Common pieces of the scaling drivers: phase timers, command line, and JSON report."""
+
+import argparse
+import json
+import os
+import sys
+import time
+from contextlib import contextmanager
+
+from mpi4py import MPI
+
+# compiled modules are built into <repo>/lib
+ROOT = os.path.abspath(os.path.join(os.path.dirname(__file__), "..", ".."))
+sys.path.insert(0, os.path.join(ROOT, "lib"))
+
+#: phases reported by every driver; unused ones stay zero
+PHASES = ("compute", "pack", "send_recv", "wait", "unpack", "balance")
+
+
+class PhaseTimer:
+    """Accumulate wall-clock time of the simulation phases on this rank."""
+
+    def __init__(self):
+        self.totals = {p: 0.0 for p in PHASES}
+
+    @contextmanager
+    def __call__(self, phase):
+        t0 = MPI.Wtime()
+        try:
+            yield
+        finally:
+            self.totals[phase] += MPI.Wtime() - t0
+
+    def split(self, phase, part, seconds):
+        """Book seconds that were timed inside phase as part instead."""
+        self.totals[phase] -= seconds
+        self.totals[part]  += seconds
+
+
+def parser(description):
+    p = argparse.ArgumentParser(description=description)
+    p.add_argument("--Nx",       type=int, default=16, help="tiles in x")
+    p.add_argument("--Ny",       type=int, default=16, help="tiles in y")
+    p.add_argument("--mesh",     type=int, default=32, help="cells per tile side")
+    p.add_argument("--steps",    type=int, default=50)
+    p.add_argument("--warmup",   type=int, default=2, help="untimed steps before measuring")
+    p.add_argument("--threads",  type=int, default=1, help="grid worker threads per rank")
+    p.add_argument("--decomposition", choices=["strides", "random"], default="strides")
+    p.add_argument("--output",   default=None, help="append the JSON record to this file")
+    p.add_argument("--label",    default="", help="free-form tag stored in the record")
+    p.add_argument("--trace",    default=None, help="write a Chrome trace of the timed steps here")
+    return p
+
+
+def load_mpi_grid(grid, decomposition, seed=0):
+    """Same partitions as the examples: x-stripes or random tiles."""
+    Nx, Ny, size = grid.get_Nx(), grid.get_Ny(), grid.size()
+    if grid.rank() == 0:
+        if decomposition == "random":
+            import numpy as np
+            owners = np.random.default_rng(seed).integers(0, size, (Nx, Ny))
+        else:
+            owners = [[i*size//Nx for _ in range(Ny)] for i in range(Nx)]
+        for i in range(Nx):
+            for j in range(Ny):
+                grid.set_mpi_grid(i, j, int(owners[i][j]))
+    grid.bcast_mpi_grid()
+
+
+def report(example, args, grid, timer, wall, extra=None):
+    """Reduce the phase timers over ranks; rank 0 prints one JSON record."""
+    comm = MPI.COMM_WORLD
+
+    phases = {}
+    for p in PHASES:
+        t = timer.totals[p]
+        phases[p] = {
+            "mean":     comm.allreduce(t, op=MPI.SUM)/comm.size,
+            "max":      comm.allreduce(t, op=MPI.MAX),
+            "per_step": comm.allreduce(t, op=MPI.MAX)/max(args.steps, 1),
+        }
+
+    ntiles = len(grid.get_local_tiles())
+    record = {
+        "example":       example,
+        "label":         args.label,
+        "ranks":         comm.size,
+        "threads":       args.threads,
+        "Nx":            args.Nx,
+        "Ny":            args.Ny,
+        "mesh":          args.mesh,
+        "steps":         args.steps,
+        "decomposition": args.decomposition,
+        "tiles_per_rank_max": comm.allreduce(ntiles, op=MPI.MAX),
+        "tiles_per_rank_min": comm.allreduce(ntiles, op=MPI.MIN),
+        "wall":          comm.allreduce(wall, op=MPI.MAX),
+        "phases":        phases,
+        "timestamp":     time.strftime("%Y-%m-%dT%H:%M:%S"),
+    }
+    if extra:
+        record.update(extra)
+
+    if comm.rank == 0:
+        line = json.dumps(record)
+        print(line)
+        if args.output:
+            with open(args.output, "a") as f:
+                f.write(line + "\n")
+
+    return record
@@ -0,0 +1,137 @@
+"""Timed particle run for scaling studies.
+
+    mpirun -np 4 python3 particles_scaling.py --Nx 16 --Ny 16 --mesh 4 --ppc 8 --steps 50
+
+Each step is: push (compute), binning of outgoing particles (pack), the
+exchange of mode 0 (send_recv + wait; boundary tiles are packed inside
+send_recv and virtual tiles are filled inside wait), and binning of the
+received particles, inter-tile transfer and clean-up (unpack). Ownership is static; particle payloads do not migrate with
+adopted tiles so there is no balance phase.
+"""
+
+import numpy as np
+
+import harness
+from harness import MPI
+
+import pycorgi
+import pyprtcls
+
+
+SPECIES_VELOCITY = (0.1, 0.5)
+
+
+def initialize_tile(grid, tile, i, j, args):
+    for _ in SPECIES_VELOCITY:
+        container = pyprtcls.ParticleBlock(args.mesh, args.mesh, 1)
+        container.reserve(args.mesh*args.mesh*args.ppc)
+        tile.set_container(container)
+
+    tile.set_tile_mins([i*args.mesh, j*args.mesh])
+    tile.set_tile_maxs([(i + 1)*args.mesh, (j + 1)*args.mesh])
+    tile.grid_mins = [grid.get_xmin(), grid.get_ymin(), 0.0]
+    tile.grid_maxs = [grid.get_xmax(), grid.get_ymax(), 1.0]
+
+
+def load_tiles(grid, args):
+    rng = np.random.default_rng(grid.rank())
+    n = args.mesh*args.mesh*args.ppc
+    for i in range(grid.get_Nx()):
+        for j in range(grid.get_Ny()):
+            if grid.get_mpi_grid(i, j) != grid.rank():
+                continue
+            tile = pyprtcls.Tile()
+            initialize_tile(grid, tile, i, j, args)
+            grid.add_tile(tile, (i, j))
+
+            # ppc particles per cell with isotropic velocities
+            for ispcs, vel in enumerate(SPECIES_VELOCITY):
+                container = tile.get_container(ispcs)
+                xs = i*args.mesh + args.mesh*rng.random(n)
+                ys = j*args.mesh + args.mesh*rng.random(n)
+                ang = 2.0*np.pi*rng.random(n)
+                zero = np.zeros(n)
+                container.add_particles(xs, ys, zero, vel*np.sin(ang), vel*np.cos(ang), zero, np.ones(n))
+
+
+def initialize_virtuals(grid, args):
+    for cid in grid.get_virtual_tiles():
+        orig = grid.get_tile(cid)
+        i, j = orig.index
+        tile = pyprtcls.Tile()
+        initialize_tile(grid, tile, i, j, args)
+        grid.replace_tile(tile, (i, j))
+
+
+def step(grid, pusher, timer):
+    with timer("compute"):
+        pusher.solve_all(grid)
+
+    with timer("pack"):
+        for cid in grid.get_local_tiles():
+            grid.get_tile(cid).check_outgoing_particles()
+
+    with timer("send_recv"):
+        grid.recv_data(0)
+        grid.send_data(0)
+    with timer("wait"):
+        grid.wait_data(0)
+
+    with timer("unpack"):
+        for cid in grid.get_virtual_tiles():
+            grid.get_tile(cid).check_outgoing_particles()
+        grid.pairwise_moore_communication(0)
+        for cid in grid.get_local_tiles():
+            grid.get_tile(cid).delete_transferred_particles()
+        for cid in grid.get_virtual_tiles():
+            grid.get_tile(cid).delete_all_particles()
+
+
+def count_particles(grid):
+    n = 0
+    for cid in grid.get_local_tiles():
+        tile = grid.get_tile(cid)
+        n += sum(tile.get_container(s).size() for s in range(len(SPECIES_VELOCITY)))
+    return MPI.COMM_WORLD.allreduce(n, op=MPI.SUM)
+
+
+if __name__ == "__main__":
+    p = harness.parser("particle scaling driver")
+    p.set_defaults(mesh=4)
+    p.add_argument("--ppc", type=int, default=4, help="particles per cell per species")
+    args = p.parse_args()
+
+    grid = pycorgi.twoD.Grid(args.Nx, args.Ny)
+    grid.set_grid_lims(0.0, args.Nx*args.mesh, 0.0, args.Ny*args.mesh)
+    grid.set_num_threads(args.threads)
+    grid.set_codec(0, pycorgi.CopyCodec())
+
+    harness.load_mpi_grid(grid, args.decomposition)
+    load_tiles(grid, args)
+
+    grid.analyze_boundaries()
+    grid.send_tiles()
+    grid.recv_tiles()
+    initialize_virtuals(grid, args)
+
+    pusher = pyprtcls.Pusher()
+
+    warm = harness.PhaseTimer()
+    for _ in range(args.warmup):
+        step(grid, pusher, warm)
+
+    if args.trace:
+        grid.start_trace()
+
+    timer = harness.PhaseTimer()
+    MPI.COMM_WORLD.barrier()
+    t0 = MPI.Wtime()
+    for _ in range(args.steps):
+        step(grid, pusher, timer)
+    wall = MPI.Wtime() - t0
+
+    if args.trace:
+        grid.write_trace(args.trace)
+
+    harness.report("particles", args, grid, timer, wall,
+                   {"ppc": args.ppc, "particles": count_particles(grid)})
@@ -0,0 +1,109 @@
+"""Weak and strong scaling sweeps over the example drivers.
+
+    python3 sweep.py gol --mode strong --ranks 1,2,4,8 --Nx 32 --Ny 32 --mesh 64
+    python3 sweep.py particles --mode weak --ranks 1,2,4,8 --tiles-per-rank 64 --mesh 4
+    python3 sweep.py gol --ranks 1,2,4 --mesh 32,128 -- --codec --threads 2
+    python3 sweep.py gol --ranks 4 --Nx 8,16,32 --Ny 8,16,32 --mesh 64
+
+Strong scaling keeps the global grid fixed. Weak scaling keeps the tiles
+per rank fixed by growing the grid in x (the strided decomposition then
+gives every rank the same number of columns). --mesh, --Nx, --Ny and
+--tiles-per-rank take lists; every combination (--Nx only in strong and
+--tiles-per-rank only in weak scaling) is swept over the rank counts.
+Every run appends one JSON record to --output; the summary table reports
+the per-step time, speedup and parallel efficiency relative to the
+smallest rank count.
+"""
+
+import argparse
+import itertools
+import json
+import os
+import shlex
+import subprocess
+import sys
+
+HERE = os.path.dirname(os.path.abspath(__file__))
+
+DRIVERS = {
+    "gol":       os.path.join(HERE, "gol_scaling.py"),
+    "particles": os.path.join(HERE, "particles_scaling.py"),
+}
+
+
+def int_list(s):
+    return [int(x) for x in s.split(",")]
+
+
+def configs(args):
+    """(mesh, Nx, Ny, tiles per rank) of every sweep; unused entries are None."""
+    Nxs  = args.Nx if args.mode == "strong" else [None]
+    tprs = args.tiles_per_rank if args.mode == "weak" else [None]
+    return itertools.product(args.mesh, Nxs, args.Ny, tprs)
+
+
+def grid_size(args, ranks, Nx, Ny, tiles_per_rank):
+    if args.mode == "strong":
+        return Nx, Ny
+    return max(1, tiles_per_rank*ranks//Ny), Ny
+
+
+def run(args, ranks, mesh, Nx, Ny, tiles_per_rank, label):
+    Nx, Ny = grid_size(args, ranks, Nx, Ny, tiles_per_rank)
+    cmd = shlex.split(args.mpirun) + ["-np", str(ranks), sys.executable, DRIVERS[args.example],
+           "--Nx", str(Nx), "--Ny", str(Ny), "--mesh", str(mesh),
+           "--steps", str(args.steps), "--threads", str(args.threads),
+           "--output", args.output, "--label", label] + args.extra
+    print("+", " ".join(cmd), flush=True)
+    out = subprocess.run(cmd, check=True, stdout=subprocess.PIPE, universal_newlines=True).stdout
+
+    # the report is the last JSON line of rank 0
+    for line in reversed(out.splitlines()):
+        if line.startswith("{"):
+            return json.loads(line)
+    raise RuntimeError("no report from " + " ".join(cmd))
+
+
+def summarize(mode, records):
+    base = records[0]
+    t0 = base["wall"]/base["steps"]
+    print("\n{:>6} {:>6} {:>6} {:>11} {:>9} {:>8} {:>11} {:>11}".format(
+        "ranks", "Nx", "Ny", "step [ms]", "speedup", "eff.", "comm [ms]", "compute [ms]"))
+    for r in records:
+        t = r["wall"]/r["steps"]
+        p = r["ranks"]/base["ranks"]
+        speedup = t0/t if mode == "strong" else p*t0/t
+        comm = 1e3*(r["phases"]["send_recv"]["per_step"] + r["phases"]["wait"]["per_step"])
+        print("{:>6} {:>6} {:>6} {:>11.3f} {:>9.2f} {:>8.2f} {:>11.3f} {:>11.3f}".format(
+            r["ranks"], r["Nx"], r["Ny"], 1e3*t, speedup, speedup/p,
+            comm, 1e3*r["phases"]["compute"]["per_step"]))
+
+
+if __name__ == "__main__":
+    p = argparse.ArgumentParser(description="weak/strong scaling sweep")
+    p.add_argument("example", choices=sorted(DRIVERS))
+    p.add_argument("--mode",    choices=["weak", "strong"], default="strong")
+    p.add_argument("--ranks",   type=int_list, default=[1, 2, 4])
+    p.add_argument("--mesh",    type=int_list, default=[32], help="tile sizes to sweep")
+    p.add_argument("--Nx",      type=int_list, default=[16], help="strong scaling grid sizes")
+    p.add_argument("--Ny",      type=int_list, default=[16])
+    p.add_argument("--tiles-per-rank", type=int_list, default=[32], help="weak scaling loads")
+    p.add_argument("--steps",   type=int, default=50)
+    p.add_argument("--threads", type=int, default=1)
+    p.add_argument("--mpirun",  default="mpirun", help="launcher command and its options")
+    p.add_argument("--output",  default="scaling.jsonl")
+
+    # everything after -- is passed to the driver as is
+    argv = sys.argv[1:]
+    split = argv.index("--") if "--" in argv else len(argv)
+    args = p.parse_args(argv[:split])
+    args.extra = argv[split + 1:]
+
+    for mesh, Nx, Ny, tiles_per_rank in configs(args):
+        if args.mode == "strong":
+            label = "{}-strong-mesh{}-{}x{}".format(args.example, mesh, Nx, Ny)
+        else:
+            label = "{}-weak-mesh{}-Ny{}-tpr{}".format(args.example, mesh, Ny, tiles_per_rank)
+        records = [run(args, ranks, mesh, Nx, Ny, tiles_per_rank, label) for ranks in args.ranks]
+        print("\n{} (mesh {}x{})".format(label, mesh, mesh))
+        summarize(args.mode, records)
@@ -0,0 +1,429 @@
+#include <string>
+#include <array>
+#include <utility>
+#include <cstring>
+#include <stdexcept>
+
+#if defined(__AVX2__) || defined(__AVX512F__)
+#include <immintrin.h>
+#endif
+
+#include "bitmesh.h"
+
+
+using namespace gol;
+
+
+/// initialize internal mesh
+BitMesh::BitMesh(int Nx, int Ny) :
+  Nx(Nx),
+  Ny(Ny),
+  W( (Nx + 2*halo + 63)/64 ),
+  stride( W + 2 )
+{
+  bits.resize( stride*(Ny + 2*halo) );
+
+  interior.resize(W);
+  for(int i=0; i<Nx; i++) {
+    const int b = i + halo;
+    interior[b/64] |= word(1) << (b%64);
+  }
+}
+
+
+BitMesh::BitMesh(const Mesh& m) : BitMesh(m.Nx, m.Ny)
+{
+  for(int j=-halo; j<Ny+halo; j++) {
+    for(int i=-halo; i<Nx+halo; i++) set(i, j, m(i,j));
+  }
+}
+
+
+Mesh BitMesh::to_mesh() const
+{
+  Mesh m(Nx, Ny);
+  for(int j=-halo; j<Ny+halo; j++) {
+    for(int i=-halo; i<Nx+halo; i++) m(i,j) = this->operator()(i,j);
+  }
+  return m;
+}
+
+
+/// Copy vertical slice
+void BitMesh::copy_vert(const BitMesh& rhs, int lhsI, int rhsI) {
+  if(this->Ny != rhs.Ny) throw std::range_error ("y dimensions do not match");
+
+  for(int j=0; j<this->Ny; j++) {
+    set(lhsI, j, rhs(rhsI, j));
+  }
+}
+
+
+/// Copy horizontal slice; whole words, interior bits only
+void BitMesh::copy_horz(const BitMesh& rhs, int lhsJ, int rhsJ) {
+  if(this->Nx != rhs.Nx) throw std::range_error ("x dimensions do not match");
+
+  word* to = row(lhsJ);
+  const word* from = rhs.row(rhsJ);
+  for(int w=0; w<W; w++) {
+    to[w] = (to[w] & ~interior[w]) | (from[w] & interior[w]);
+  }
+}
+
+
+
+// --------------------------------------------------
+
+
+/// Update boundary/halo regions from neighbors
+void BitTile::update_boundaries(corgi::Grid<2>& grid)
+{
+  int ito=0, jto=0, ifro=0, jfro=0;
+  Tileptr tpr;
+
+  BitMesh& mesh = get_data(); // target as a reference to update into
+
+  for(int in=-1; in <= 1; in++) {
+    for(int jn=-1; jn <= 1; jn++) {
+      if (in == 0 && jn == 0) continue;
+
+      tpr = std::dynamic_pointer_cast<Tile_t>(grid.get_tileptr( neighs(in, jn) ));
+      if (tpr) {
+        BitMesh& mpr = tpr->get_data();
+
+        // same diagonal rules as in Tile::update_boundaries
+        if (in == +1) { ito = mesh.Nx; ifro = 0; }
+        if (jn == +1) { jto = mesh.Ny; jfro = 0; }
+
+        if (in == -1) { ito = -1;      ifro = mpr.Nx-1; }
+        if (jn == -1) { jto = -1;      jfro = mpr.Ny-1; }
+
+        // copy
+        if      (jn == 0) mesh.copy_vert(mpr, ito, ifro);             // vertical
+        else if (in == 0) mesh.copy_horz(mpr, jto, jfro);             // horizontal
+        else              mesh.set(ito, jto, mpr(ifro, jfro));        // diagonal
+
+      } // end of if(tpr)
+    }
+  }
+
+}
+
+std::vector<mpi4cpp::mpi::request> BitTile::send_data(
+    mpi4cpp::mpi::communicator& comm,
+    int dest,
+    int /*mode*/,
+    int tag)
+{
+  BitMesh& mesh = get_data();
+
+  std::vector<mpi4cpp::mpi::request> reqs;
+  reqs.push_back( comm.isend(dest, tag,
+        reinterpret_cast<char*>(mesh.bits.data()), mesh.size_bytes()) );
+
+  return reqs;
+}
+
+std::vector<mpi4cpp::mpi::request> BitTile::recv_data(
+    mpi4cpp::mpi::communicator& comm,
+    int orig,
+    int /*mode*/,
+    int tag)
+{
+  BitMesh& mesh = get_data();
+
+  std::vector<mpi4cpp::mpi::request> reqs;
+  reqs.push_back( comm.irecv(orig, tag,
+        reinterpret_cast<char*>(mesh.bits.data()), mesh.size_bytes()) );
+
+  return reqs;
+}
+
+
+size_t BitTile::data_size(
+    int /*dest*/,
+    int /*mode*/) const
+{
+  return data.get().size_bytes();
+}
+
+namespace {
+
+/// words [w0,w1) of rows [j0,j1) holding the interior cells read by the neighbor in direction (in,jn)
+//
+// Whole words are sent; the extra cells in them are current values of the
+// same tile, so overwriting them in the virtual copy is harmless.
+std::array<int,4> strip_words(const BitMesh& m, int in, int jn)
+{
+  auto range = [h = m.halo](int dir, int n) {
+    return dir > 0 ? std::make_pair(n - h, n) : (dir < 0 ? std::make_pair(0, h) : std::make_pair(0, n));
+  };
+  auto [i0, i1] = range(in, m.Nx);
+  auto [j0, j1] = range(jn, m.Ny);
+  return {(i0 + m.halo)/64, (i1 - 1 + m.halo)/64 + 1, j0, j1};
+}
+
+} // end of anonymous namespace
+
+
+size_t BitTile::packed_size(
+    int dest,
+    int /*mode*/) const
+{
+  auto it = halo_directions.find(dest);
+  if(it == halo_directions.end()) return 0;
+
+  size_t n = 0;
+  const BitMesh& mesh = data.get();
+  for(auto& [in, jn] : it->second) {
+    const auto [w0, w1, j0, j1] = strip_words(mesh, in, jn);
+    n += (w1 - w0)*(j1 - j0)*sizeof(BitMesh::word);
+  }
+  return n;
+}
+
+void BitTile::pack_data(
+    std::vector<char>& buf,
+    int dest,
+    int /*mode*/)
+{
+  BitMesh& mesh = get_data();
+
+  auto it = halo_directions.find(dest);
+  if(it == halo_directions.end()) return;
+
+  for(auto& [in, jn] : it->second) {
+    const auto [w0, w1, j0, j1] = strip_words(mesh, in, jn);
+    for(int j=j0; j<j1; j++) {
+      const char* c = reinterpret_cast<const char*>(mesh.row(j) + w0);
+      buf.insert(buf.end(), c, c + (w1 - w0)*sizeof(BitMesh::word));
+    }
+  }
+}
+
+void BitTile::unpack_data(
+    const char* buf,
+    size_t size,
+    int /*orig*/,
+    int mode)
+{
+  if(size != packed_size(halo_rank, mode)) throw std::length_error("halo strips do not match message");
+  if(size == 0) return;
+
+  BitMesh& mesh = get_data();
+  for(auto& [in, jn] : halo_directions.at(halo_rank)) {
+    const auto [w0, w1, j0, j1] = strip_words(mesh, in, jn);
+    for(int j=j0; j<j1; j++) {
+      std::memcpy(mesh.row(j) + w0, buf, (w1 - w0)*sizeof(BitMesh::word));
+      buf += (w1 - w0)*sizeof(BitMesh::word);
+    }
+  }
+}
+
+
+
+// --------------------------------------------------
+// Bit-sliced kernel
+//
+// Each bit position of a word is one cell. The 3x3 sum (center included)
+// of all cells of a word is accumulated with full adders that act on
+// whole words: first the three cells of each row (left, center, right)
+// are added into a 2-bit number (s, c), then the three rows are added.
+// The new cell is alive iff the sum is 3 or it was alive already, as in
+// Solver::solve.
+//
+// The kernel is written once for a set of word operations and compiled
+// for 64-bit scalars, AVX2 (4 words), and AVX-512 (8 words); the widest
+// available one is chosen at compile time (e.g., -march=native).
+
+namespace {
+
+using word = BitMesh::word;
+
+
+struct scalar_ops {
+  using V = word;
+  static constexpr int width = 1;
+
+  static V load(const word* p) { return *p; }
+  static void store(word* p, V x) { *p = x; }
+
+  static V op_and(V a, V b) { return a & b; }
+  static V op_or (V a, V b) { return a | b; }
+  static V op_xor(V a, V b) { return a ^ b; }
+  static V andnot(V a, V b) { return ~a & b; }
+
+  static V shl1 (V x) { return x << 1; }
+  static V shr1 (V x) { return x >> 1; }
+  static V shl63(V x) { return x << 63; }
+  static V shr63(V x) { return x >> 63; }
+
+  static V zero() { return 0; }
+  static bool any(V x) { return x != 0; }
+};
+
+
+#if defined(__AVX2__)
+struct avx2_ops {
+  using V = __m256i;
+  static constexpr int width = 4;
+
+  static V load(const word* p) { return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p)); }
+  static void store(word* p, V x) { _mm256_storeu_si256(reinterpret_cast<__m256i*>(p), x); }
+
+  static V op_and(V a, V b) { return _mm256_and_si256(a, b); }
+  static V op_or (V a, V b) { return _mm256_or_si256 (a, b); }
+  static V op_xor(V a, V b) { return _mm256_xor_si256(a, b); }
+  static V andnot(V a, V b) { return _mm256_andnot_si256(a, b); }
+
+  static V shl1 (V x) { return _mm256_slli_epi64(x, 1);  }
+  static V shr1 (V x) { return _mm256_srli_epi64(x, 1);  }
+  static V shl63(V x) { return _mm256_slli_epi64(x, 63); }
+  static V shr63(V x) { return _mm256_srli_epi64(x, 63); }
+
+  static V zero() { return _mm256_setzero_si256(); }
+  static bool any(V x) { return !_mm256_testz_si256(x, x); }
+};
+#endif
+
+
+#if defined(__AVX512F__)
+struct avx512_ops {
+  using V = __m512i;
+  static constexpr int width = 8;
+
+  static V load(const word* p) { return _mm512_loadu_si512(p); }
+  static void store(word* p, V x) { _mm512_storeu_si512(p, x); }
+
+  static V op_and(V a, V b) { return _mm512_and_si512(a, b); }
+  static V op_or (V a, V b) { return _mm512_or_si512 (a, b); }
+  static V op_xor(V a, V b) { return _mm512_xor_si512(a, b); }
+  static V andnot(V a, V b) { return _mm512_andnot_si512(a, b); }
+
+  static V shl1 (V x) { return _mm512_slli_epi64(x, 1);  }
+  static V shr1 (V x) { return _mm512_srli_epi64(x, 1);  }
+  static V shl63(V x) { return _mm512_slli_epi64(x, 63); }
+  static V shr63(V x) { return _mm512_srli_epi64(x, 63); }
+
+  static V zero() { return _mm512_setzero_si512(); }
+  static bool any(V x) { return _mm512_test_epi64_mask(x, x) != 0; }
+};
+#endif
+
+
+/// full adder: a+b+c = s + 2*carry, bitwise
+template<class Ops>
+inline void full_add(
+    typename Ops::V a, typename Ops::V b, typename Ops::V c,
+    typename Ops::V& s, typename Ops::V& carry)
+{
+  const auto ab = Ops::op_xor(a, b);
+  s     = Ops::op_xor(ab, c);
+  carry = Ops::op_or( Ops::op_and(a, b), Ops::op_and(ab, c) );
+}
+
+
+/// sum of the cell and its left and right neighbors for all cells of p[0]
+template<class Ops>
+inline void row_sum(const word* p, typename Ops::V& s, typename Ops::V& carry)
+{
+  const auto x = Ops::load(p);
+
+  // bit b of left (right) is the cell at bit b-1 (b+1)
+  const auto left  = Ops::op_or( Ops::shl1(x), Ops::shr63(Ops::load(p-1)) );
+  const auto right = Ops::op_or( Ops::shr1(x), Ops::shl63(Ops::load(p+1)) );
+
+  full_add<Ops>(left, x, right, s, carry);
+}
+
+
+/// new state of words [w, W) of a row; returns the first word not done
+//
+// changed is set if any cell changed.
+template<class Ops>
+int step_words(
+    const word* up, const word* mid, const word* dn,
+    const word* interior,
+    word* out,
+    int w, int W,
+    bool& changed)
+{
+  using V = typename Ops::V;
+  V diff = Ops::zero();
+
+  for(; w + Ops::width <= W; w += Ops::width) {
+    V s_u, c_u, s_m, c_m, s_d, c_d;
+    row_sum<Ops>(up  + w, s_u, c_u);
+    row_sum<Ops>(mid + w, s_m, c_m);
+    row_sum<Ops>(dn  + w, s_d, c_d);
+
+    // sum = ones + 2*(twos_a + twos_b) + 4*fours; rows give at most 2*3 per bit
+    V ones, twos_a, twos_b, fours;
+    full_add<Ops>(s_u, s_m, s_d, ones, twos_a);
+    full_add<Ops>(c_u, c_m, c_d, twos_b, fours);
+
+    // sum == 3 <=> ones=1, exactly one of the twos, no fours
+    const V three = Ops::andnot( fours, Ops::op_and(ones, Ops::op_xor(twos_a, twos_b)) );
+
+    const V in    = Ops::load(interior + w);
+    const V x     = Ops::op_and(Ops::load(mid + w), in);
+    const V alive = Ops::op_and(Ops::op_or(three, x), in);
+    Ops::store(out + w, alive);
+    diff = Ops::op_or(diff, Ops::op_xor(alive, x));
+  }
+
+  changed = changed || Ops::any(diff);
+  return w;
+}
+
+} // end of anonymous namespace
+
+
+void BitSolver::solve(BitTile& tile) {
+  const BitMesh& m = tile.get_data();
+  BitMesh& mnew    = tile.get_new_data();
+
+  // halo rows are not written: they still hold either zeros (no
+  // neighbor) or old neighbor data that update_boundaries overwrites
+
+  const word* interior = m.interior.data();
+
+  bool changed = false;
+  for(int j=0; j<m.Ny; j++) {
+    const word* up  = m.row(j-1);
+    const word* mid = m.row(j);
+    const word* dn  = m.row(j+1);
+    word* out       = mnew.row(j);
+
+    int w = 0;
+#if defined(__AVX512F__)
+    w = step_words<avx512_ops>(up, mid, dn, interior, out, w, m.W, changed);
+#endif
+#if defined(__AVX2__)
+    w = step_words<avx2_ops>  (up, mid, dn, interior, out, w, m.W, changed);
+#endif
+    step_words<scalar_ops>    (up, mid, dn, interior, out, w, m.W, changed);
+  }
+
+  if(track_activity) tile.active = changed;
+}
+
+
+void BitSolver::solve_all(corgi::Grid<2>& grid)
+{
+  grid.for_each_active_tile([this](corgi::Tile<2>& tile) {
+    solve( dynamic_cast<BitTile&>(tile) );
+  });
+}
+
+
+const char* BitSolver::simd()
+{
+#if defined(__AVX512F__)
+  return "avx512";
+#elif defined(__AVX2__)
+  return "avx2";
+#else
+  return "scalar";
+#endif
+}
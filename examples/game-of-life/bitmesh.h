@@ -0,0 +1,153 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+
+#include "corgi/tile.h"
+#include "corgi/corgi.h"
+#include "corgi/toolbox/dataContainer.h"
+#include "corgi/toolbox/aligned_allocator.h"
+
+#include <mpi4cpp/mpi.h>
+
+#include "gol.h"
+
+
+namespace gol {
+
+
+/// Bit-packed CA patch; 64 cells per word
+//
+// Row j (including the halo rows) stores cells i = -halo..Nx+halo-1 as
+// bits i+halo of consecutive words. Every row is padded with a zero word
+// on both sides so that kernels can read the neighbor words of any word.
+class BitMesh {
+
+  public:
+
+  using word = uint64_t;
+
+  /// patch dimensions
+  int Nx;
+  int Ny;
+
+  int halo = 1;
+
+  /// words per row
+  int W;
+
+  /// distance of rows in words (W + 2 pad words)
+  int stride;
+
+  /// Internal storage of all rows (cache-line aligned)
+  corgi::tools::aligned_vector<word> bits;
+
+  /// 1 for interior cells (i = 0..Nx-1) of the W words of a row
+  corgi::tools::aligned_vector<word> interior;
+
+  BitMesh(int Nx, int Ny);
+
+  /// bit-identical copy of an int mesh
+  explicit BitMesh(const Mesh& m);
+
+  /// back to an int mesh
+  Mesh to_mesh() const;
+
+  /// first word of row j
+  word* row(const int j) { return bits.data() + (j+halo)*stride + 1; }
+  const word* row(const int j) const { return bits.data() + (j+halo)*stride + 1; }
+
+  int operator () (const int i, const int j) const {
+    const int b = i + halo;
+    return static_cast<int>( (row(j)[b/64] >> (b%64)) & 1u );
+  }
+
+  void set(const int i, const int j, const int val) {
+    const int b = i + halo;
+    const word m = word(1) << (b%64);
+    word& w = row(j)[b/64];
+    w = val ? (w | m) : (w & ~m);
+  }
+
+  void clear()
+  {
+    std::fill(bits.begin(), bits.end(), 0);
+  }
+
+  /// bytes of the bit storage (sent in halo messages)
+  size_t size_bytes() const { return bits.size()*sizeof(word); }
+
+  void copy_vert(const BitMesh& rhs, int lhsI, int rhsI);
+
+  void copy_horz(const BitMesh& rhs, int lhsJ, int rhsJ);
+
+};
+
+
+/// CA tile storing bit-packed meshes
+class BitTile : public corgi::Tile<2> {
+
+  public:
+
+    using Tile_t = BitTile;
+    using Tileptr = std::shared_ptr<BitTile>;
+
+    BitTile() = default;
+
+    ~BitTile() override = default;
+
+    datarotators::Rotator<BitMesh,2> data;
+
+    void add_data(BitMesh m) { data.push_back( std::move(m) ); }
+
+    BitMesh& emplace_data(int Nx, int Ny) { return data.emplace_back(Nx, Ny); }
+
+    BitMesh& get_data() { return data.get(); }
+
+    BitMesh& get_new_data() { return data.get(1); }
+
+    void update_boundaries(corgi::Grid<2>& grid);
+
+    /// step forward
+    void cycle() { data.cycle(); }
+
+    std::vector<mpi4cpp::mpi::request>
+    send_data( mpi4cpp::mpi::communicator&, int orig, int mode, int tag) override;
+
+    std::vector<mpi4cpp::mpi::request>
+    recv_data( mpi4cpp::mpi::communicator&, int dest, int mode, int tag) override;
+
+    size_t data_size(int dest, int mode) const override;
+
+    /// bytes of the halo strip words that pack_data sends to dest
+    size_t packed_size(int dest, int mode) const override;
+
+    /// halo exchange through the grid (used when the mode has a codec);
+    //  only the words of the strips read by the tiles of dest are sent
+    void pack_data(std::vector<char>& buf, int dest, int mode) override;
+
+    void unpack_data(const char* buf, size_t size, int orig, int mode) override;
+
+};
+
+
+/// Same rules as Solver, 64 cells at a time with a bit-sliced adder
+class BitSolver {
+
+  public:
+
+    /// set tile.active to whether the tile changed (see Grid::exchange_activity)
+    bool track_activity = false;
+
+    void solve(BitTile&);
+
+    /// solve all active local tiles of the grid (threaded over tiles)
+    void solve_all(corgi::Grid<2>& grid);
+
+    /// instruction set of the kernel: "avx512", "avx2", or "scalar"
+    static const char* simd();
+
+};
+
+
+} // end of namespace gol
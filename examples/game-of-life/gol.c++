@@ -1,6 +1,13 @@
 #include <string>
+#include <vector>
+#include <array>
+#include <cstdint>
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
 
 #include "gol.h"
+#include "bitmesh.h"
 #include "corgi/toolbox/dataContainer.h"
 
 
@@ -8,7 +15,8 @@ using namespace gol;
 
 
 /// initialize internal mesh
-Mesh::Mesh(int Nx, int Ny) : Nx(Nx), Ny(Ny) {
+Mesh::Mesh(int Nx, int Ny, int halo) : Nx(Nx), Ny(Ny), halo(halo) {
+  if(halo < 1) throw std::invalid_argument("halo must be positive");
   mesh.resize((Nx + 2*halo) * (Ny + 2*halo));    
 }
 
@@ -39,7 +47,7 @@ void Mesh::copy_horz(Mesh& rhs, int lhsJ, int rhsJ) {
 
 /// Add data to the container
 void Tile::add_data(Mesh m) {
-  data.push_back(m);
+  data.push_back( std::move(m) );
 }
 
 
@@ -57,10 +65,20 @@ Mesh& Tile::get_new_data() {
 /// Update boundary/halo regions from neighbors
 void Tile::update_boundaries(corgi::Grid<2>& grid) 
 {
-  int ito=0, jto=0, ifro=0, jfro=0;
   Tileptr tpr;
 
   Mesh& mesh = get_data(); // target as a reference to update into
+  const int h = mesh.halo;
+
+  /* slice s = 0..h-1 counted from the edge; rules are:
+  if + then to   n+s
+  if + then from s
+
+  if - then to   -1-s
+  if - then from n-1-s
+  */
+  auto to   = [](int dir, int n, int s) { return dir > 0 ? n + s : -1 - s; };
+  auto from = [](int dir, int n, int s) { return dir > 0 ? s     : n - 1 - s; };
 
   for(int in=-1; in <= 1; in++) {
     for(int jn=-1; jn <= 1; jn++) {
@@ -69,25 +87,20 @@ void Tile::update_boundaries(corgi::Grid<2>& grid)
       tpr = std::dynamic_pointer_cast<Tile_t>(grid.get_tileptr( neighs(in, jn) ));
       if (tpr) {
         Mesh& mpr = tpr->get_data();
-
-        /* diagonal rules are:
-        if + then to   n
-        if + then from 0
-
-        if - then to   -1
-        if - then from n-1
-        */
-
-        if (in == +1) { ito = mesh.Nx; ifro = 0; }
-        if (jn == +1) { jto = mesh.Ny; jfro = 0; }
-
-        if (in == -1) { ito = -1;      ifro = mpr.Nx-1; }
-        if (jn == -1) { jto = -1;      jfro = mpr.Ny-1; }
+        if (mpr.Nx < h || mpr.Ny < h) throw std::range_error ("neighbor is thinner than the halo");
 
         // copy
-        if      (jn == 0) mesh.copy_vert(mpr, ito, ifro);   // vertical
-        else if (in == 0) mesh.copy_horz(mpr, jto, jfro);   // horizontal
-        else              mesh(ito, jto) = mpr(ifro, jfro); // diagonal
+        if (jn == 0) {                                        // vertical
+          for(int s=0; s<h; s++) mesh.copy_vert(mpr, to(in, mesh.Nx, s), from(in, mpr.Nx, s));
+        } else if (in == 0) {                                 // horizontal
+          for(int s=0; s<h; s++) mesh.copy_horz(mpr, to(jn, mesh.Ny, s), from(jn, mpr.Ny, s));
+        } else {                                              // diagonal
+          for(int si=0; si<h; si++) {
+            for(int sj=0; sj<h; sj++) {
+              mesh(to(in, mesh.Nx, si), to(jn, mesh.Ny, sj)) = mpr(from(in, mpr.Nx, si), from(jn, mpr.Ny, sj));
+            }
+          }
+        }
         
       } // end of if(tpr)
     }
@@ -126,36 +139,198 @@ std::vector<mpi4cpp::mpi::request> Tile::recv_data(
 }
 
 
-void Solver::solve(Tile& tile) {
-  Mesh& m    = tile.get_data();
-  Mesh& mnew = tile.get_new_data();
-  mnew.clear();
+size_t Tile::data_size(
+    int /*dest*/,
+    int /*mode*/) const
+{
+  return data.get().mesh.size()*sizeof(int);
+}
+
+namespace {
+
+/// interior cells [i0,i1) x [j0,j1) read by the neighbor in direction (in,jn)
+std::array<int,4> strip(const Mesh& m, int in, int jn)
+{
+  auto range = [h = m.halo](int dir, int n) {
+    return dir > 0 ? std::make_pair(n - h, n) : (dir < 0 ? std::make_pair(0, h) : std::make_pair(0, n));
+  };
+  auto [i0, i1] = range(in, m.Nx);
+  auto [j0, j1] = range(jn, m.Ny);
+  return {i0, i1, j0, j1};
+}
 
-  for(int i=0; i<(int)m.Nx; i++) { 
-    for(int j=0; j<(int)m.Ny; j++) { 
+} // end of anonymous namespace
 
-      // count how many are alive
-      int alive = 0;
-      for(int ir=-1; ir<2; ir++) {
-        for(int jr=-1; jr<2; jr++) {
-          int state = m( i + ir, j + jr );
 
-          if(state == 1) { alive++; }
-        }
-      }
+size_t Tile::packed_size(
+    int dest,
+    int /*mode*/) const
+{
+  auto it = halo_directions.find(dest);
+  if(it == halo_directions.end()) return 0;
+
+  size_t n = 0;
+  const Mesh& mesh = data.get();
+  for(auto& [in, jn] : it->second) {
+    const auto [i0, i1, j0, j1] = strip(mesh, in, jn);
+    n += (i1 - i0)*(j1 - j0)*sizeof(int);
+  }
+  return n;
+}
+
+
+/// Halo strips facing the tiles of dest
+//
+// Message is the strips of each direction of halo_directions[dest] row by
+// row, cells only. The virtual copy on dest has the same directions in
+// halo_directions[halo_rank], so it is updated only where it is read.
+void Tile::pack_data(
+    std::vector<char>& buf,
+    int dest,
+    int /*mode*/)
+{
+  Mesh& mesh = get_data(); 
+
+  auto it = halo_directions.find(dest);
+  if(it == halo_directions.end()) return;
 
-      // apply rules
-      if(alive == 3) {
-        mnew(i,j) = 1;
-      } else {
-        mnew(i,j) = m(i,j);
+  for(auto& [in, jn] : it->second) {
+    const auto [i0, i1, j0, j1] = strip(mesh, in, jn);
+    for(int j=j0; j<j1; j++) {
+      const char* c = reinterpret_cast<const char*>(&mesh(i0, j));
+      buf.insert(buf.end(), c, c + (i1 - i0)*sizeof(int));
+    }
+  }
+}
+
+void Tile::unpack_data(
+    const char* buf,
+    size_t size,
+    int /*orig*/,
+    int mode)
+{
+  if(size != packed_size(halo_rank, mode)) throw std::length_error("halo strips do not match message");
+  if(size == 0) return;
+
+  Mesh& mesh = get_data(); 
+  for(auto& [in, jn] : halo_directions.at(halo_rank)) {
+    const auto [i0, i1, j0, j1] = strip(mesh, in, jn);
+    for(int j=j0; j<j1; j++) {
+      std::memcpy(&mesh(i0, j), buf, (i1 - i0)*sizeof(int));
+      buf += (i1 - i0)*sizeof(int);
+    }
+  }
+}
+
+
+namespace {
+
+/// One generation of m into mnew on cells [ia,ib) x [ja,jb); true if any cell changed
+//
+// Row sweep with running column sums: cs[k] holds the live cells of
+// column ia-1+k in rows j-1..j+1. Moving to the next row adds row j+2 and
+// removes row j-1, so every cell is read a constant number of times, and
+// all loops are over contiguous rows (auto-vectorized). Columns are swept
+// in blocks of bw cells to keep the rows of a block in cache for large
+// tiles.
+bool sweep(const Mesh& m, Mesh& mnew, int ia, int ib, int ja, int jb, int bw)
+{
+  std::vector<int> cs(bw + 2);
+  int changed = 0;
+
+  for(int i0=ia; i0<ib; i0+=bw) {
+    const int n = std::min(bw, ib - i0);
+
+    const int* r0 = &m.mesh[ m.indx(i0-1, ja-1) ];
+    const int* r1 = &m.mesh[ m.indx(i0-1, ja  ) ];
+    for(int k=0; k<n+2; k++) cs[k] = (r0[k] == 1) + (r1[k] == 1);
+
+    for(int j=ja; j<jb; j++) {
+      const int* add = &m.mesh[ m.indx(i0-1, j+1) ];
+      for(int k=0; k<n+2; k++) cs[k] += (add[k] == 1);
+
+      // apply rules; 3x3 sum includes the cell itself
+      const int* old = &m.mesh[ m.indx(i0, j) ];
+      int* out = &mnew.mesh[ mnew.indx(i0, j) ];
+      for(int k=0; k<n; k++) {
+        const int alive = cs[k] + cs[k+1] + cs[k+2];
+        out[k] = (alive == 3) ? 1 : old[k];
+        changed |= out[k] ^ old[k];
       }
 
-      // } else if(alive != 2) {
-      //   mnew(i,j) = 0;
+      const int* sub = &m.mesh[ m.indx(i0-1, j-1) ];
+      for(int k=0; k<n+2; k++) cs[k] -= (sub[k] == 1);
     }
   }
+
+  return changed != 0;
 }
 
+} // end of anonymous namespace
+
 
+void Solver::solve(Tile& tile, int steps) {
+  const int h = tile.get_data().halo;
+  if(steps < 1 || steps > h) throw std::invalid_argument("steps must be in [1, halo]");
 
+  bool changed = false;
+  for(int s=0; s<steps; s++) {
+    if(s > 0) tile.cycle();
+
+    const Mesh& m = tile.get_data();
+    Mesh& mnew    = tile.get_new_data();
+
+    // cells beyond the interior that are still needed by later generations
+    const int e  = steps - 1 - s;
+    const int Nx = m.Nx;
+    const int Ny = m.Ny;
+    const int bw = (block > 0 && block < Nx + 2*e) ? block : Nx + 2*e;
+
+    changed |= sweep(m, mnew, -e, Nx + e, -e, Ny + e, bw);
+  }
+
+  if(track_activity) tile.active = changed;
+
+  // halo rings 0..steps-2 may hold intermediate generations; outside the
+  // grid they must read as dead cells, elsewhere update_boundaries
+  // overwrites them
+  const int r = steps - 1;
+  if(r == 0) return;
+
+  Mesh& mnew = tile.get_new_data();
+  const int Nx = mnew.Nx;
+  const int Ny = mnew.Ny;
+  for(int j=-r; j<Ny+r; j++) {
+    if(j < 0 || j >= Ny) {
+      for(int i=-r; i<Nx+r; i++) mnew(i, j) = 0;
+    } else {
+      for(int s=0; s<r; s++) { mnew(-1-s, j) = 0; mnew(Nx+s, j) = 0; }
+    }
+  }
+}
+
+
+void Solver::solve_all(corgi::Grid<2>& grid, int steps) 
+{
+  grid.for_each_active_tile([this, steps](corgi::Tile<2>& tile) {
+    solve( dynamic_cast<Tile&>(tile), steps );
+  });
+}
+
+
+void gol::update_boundaries(corgi::Grid<2>& grid) 
+{
+  grid.for_each_active_tile([&grid](corgi::Tile<2>& tile) {
+    if(auto* bt = dynamic_cast<BitTile*>(&tile)) bt->update_boundaries(grid);
+    else dynamic_cast<Tile&>(tile).update_boundaries(grid);
+  });
+}
+
+
+void gol::cycle(corgi::Grid<2>& grid) 
+{
+  grid.for_each_active_tile([](corgi::Tile<2>& tile) {
+    if(auto* bt = dynamic_cast<BitTile*>(&tile)) bt->cycle();
+    else dynamic_cast<Tile&>(tile).cycle();
+  });
+}
@@ -5,6 +5,7 @@
 #include "corgi/tile.h"
 #include "corgi/corgi.h"
 #include "corgi/toolbox/dataContainer.h"
+#include "corgi/toolbox/aligned_allocator.h"
 
 #include <mpi4cpp/mpi.h>
 
@@ -22,15 +23,16 @@ class Mesh {
   int Nx;
   int Ny;
 
+  /// width of the halo regions; generations that can be solved per exchange
   int halo = 1;
 
-  /// Internal 2D mesh storing the values
-  std::vector<int> mesh;
+  /// Internal 2D mesh storing the values (cache-line aligned)
+  corgi::tools::aligned_vector<int> mesh;
 
   /// ctor
-  Mesh(int Nx, int Ny);
+  Mesh(int Nx, int Ny, int halo = 1);
 
-  // Indexing with +1 halo regions around the array
+  // Indexing with +halo regions around the array
   int indx(const int i, const int j) const {
     return (i+halo) + (Nx +2*halo)*(j+halo);
   }
@@ -100,8 +102,12 @@ class Tile : public corgi::Tile<2> {
     // extending the base class
     datarotators::Rotator<Mesh,2> data;
 
+    /// add a buffer; the mesh is moved into the rotator
     void add_data(Mesh m);
 
+    /// construct a buffer in place
+    Mesh& emplace_data(int Nx, int Ny, int halo = 1) { return data.emplace_back(Nx, Ny, halo); }
+
     Mesh& get_data();
 
     Mesh* get_dataptr();
@@ -119,6 +125,17 @@ class Tile : public corgi::Tile<2> {
     std::vector<mpi4cpp::mpi::request> 
     recv_data( mpi4cpp::mpi::communicator&, int dest, int mode, int tag) override;
 
+    size_t data_size(int dest, int mode) const override;
+
+    /// bytes of the halo strips that pack_data sends to dest
+    size_t packed_size(int dest, int mode) const override;
+
+    /// halo exchange through the grid (used when the mode has a codec);
+    //  only the strips read by the tiles of dest are sent
+    void pack_data(std::vector<char>& buf, int dest, int mode) override;
+
+    void unpack_data(const char* buf, size_t size, int orig, int mode) override;
+
 };
 
 
@@ -126,11 +143,42 @@ class Tile : public corgi::Tile<2> {
 class Solver {
 
   public:
-    void solve(Tile&);
+
+    /// width of the column blocks swept at a time (<= 0: whole rows);
+    //  for tiles whose rows do not fit in cache
+    int block = 0;
+
+    /// set tile.active to whether the tile changed (see Grid::exchange_activity)
+    bool track_activity = false;
+
+    /// advance steps (<= mesh halo) generations; the result is in the new data
+    //
+    // Generation s (from 0) is also computed on the inner steps-1-s rings
+    // of the halo, so one halo exchange suffices for up to halo
+    // generations. The tile is cycled steps-1 times in between.
+    //
+    // The new data is overwritten, not cleared: all interior cells are
+    // written, and only the halo rings written by earlier generations are
+    // zeroed (none for steps = 1). Other halo cells keep their old values,
+    // which update_boundaries replaces where a neighbor exists.
+    void solve(Tile&, int steps = 1);
+
+    /// solve all active local tiles of the grid (threaded over tiles)
+    void solve_all(corgi::Grid<2>& grid, int steps = 1);
 
 };
 
 
+/// update halo regions of all active local tiles (Tile or BitTile)
+void update_boundaries(corgi::Grid<2>& grid);
+
+/// step all active local tiles forward in time
+//
+// With activity tracking a tile that did not change keeps its data, which
+// equals the new data.
+void cycle(corgi::Grid<2>& grid);
+
+
 
 
 
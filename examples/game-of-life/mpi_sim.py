@@ -105,14 +105,15 @@ if __name__ == "__main__":
     #grid.send_data(0)
     #grid.recv_data(0)
 
+    # cells are 0/1; send the halos bit-packed 
+    grid.set_codec(0, pycorgi.BitpackCodec())
+
 
     for lap in range(1, 301):
         print("---lap: {}".format(lap))
 
         #send/recv boundaries
-        grid.send_data(0)
-        grid.recv_data(0)
-        grid.wait_data(0)
+        grid.exchange_data(0)
 
         if (lap % 10 == 0):
             plotNode(axs[0], grid, conf)
@@ -120,19 +121,17 @@ if __name__ == "__main__":
             saveVisz(lap, grid, conf)
 
         #update halo regions
-        for cid in grid.get_local_tiles():
-            c = grid.get_tile(cid)
-            c.update_boundaries(grid)
+        pyca.update_boundaries(grid)
 
         #progress one time step
-        for cid in grid.get_local_tiles():
-            c = grid.get_tile(cid)
-            sol.solve(c)
+        sol.solve_all(grid)
 
         #cycle everybody in time
-        for cid in grid.get_local_tiles():
-            c = grid.get_tile(cid)
-            c.cycle()
+        pyca.cycle(grid)
+
+    stats = grid.get_codec_stats(0)
+    print("{}: halo messages compressed {:.1f}x ({} -> {} bytes)".format(
+        grid.rank(), stats.ratio(), stats.raw_bytes_sent, stats.encoded_bytes_sent))
 
     
     
@@ -3,6 +3,7 @@
 namespace py = pybind11;
     
 #include "gol.h"
+#include "bitmesh.h"
 #include "corgi/toolbox/dataContainer.h"
 
 
@@ -10,10 +11,25 @@ PYBIND11_MODULE(pyca, m) {
 
 
   /// Bind 2D Mesh 
-  py::class_<gol::Mesh>(m, "Mesh")
-    .def(py::init<int, int>())
+  //
+  // numpy.asarray(mesh) is a view to the mesh memory (including halo 
+  // regions) indexed as [i+halo, j+halo].
+  py::class_<gol::Mesh>(m, "Mesh", py::buffer_protocol())
+    .def(py::init<int, int, int>(), py::arg("Nx"), py::arg("Ny"), py::arg("halo") = 1)
+    .def_buffer([](gol::Mesh& s) -> py::buffer_info 
+      {
+        return py::buffer_info(
+            s.mesh.data(),
+            sizeof(int),
+            py::format_descriptor<int>::format(),
+            2,
+            { s.Nx + 2*s.halo, s.Ny + 2*s.halo },
+            { sizeof(int), sizeof(int)*(s.Nx + 2*s.halo) }
+            );
+      })
     .def_readwrite("Nx",  &gol::Mesh::Nx)
     .def_readwrite("Ny",  &gol::Mesh::Ny)
+    .def_readonly("halo", &gol::Mesh::halo)
     .def("__getitem__", [](const gol::Mesh &s, py::tuple indx) 
       {
         int i = indx[0].cast<int>();
@@ -42,6 +58,36 @@ PYBIND11_MODULE(pyca, m) {
       });
 
 
+  /// Bind bit-packed 2D mesh; no buffer view, convert with to_mesh()
+  py::class_<gol::BitMesh>(m, "BitMesh")
+    .def(py::init<int, int>())
+    .def(py::init<const gol::Mesh&>())
+    .def_readonly("Nx",  &gol::BitMesh::Nx)
+    .def_readonly("Ny",  &gol::BitMesh::Ny)
+    .def("to_mesh",      &gol::BitMesh::to_mesh)
+    .def("size_bytes",   &gol::BitMesh::size_bytes)
+    .def("__getitem__", [](const gol::BitMesh &s, py::tuple indx) 
+      {
+        int i = indx[0].cast<int>();
+        int j = indx[1].cast<int>();
+
+        if (i < -s.halo || i >= s.Nx+s.halo) throw py::index_error();
+        if (j < -s.halo || j >= s.Ny+s.halo) throw py::index_error();
+
+        return s(i,j);
+      })
+    .def("__setitem__", [](gol::BitMesh &s, py::tuple indx, int val) 
+      {
+        int i = indx[0].cast<int>();
+        int j = indx[1].cast<int>();
+
+        if (i < -s.halo || i >= s.Nx+s.halo) throw py::index_error();
+        if (j < -s.halo || j >= s.Ny+s.halo) throw py::index_error();
+
+        s.set(i,j,val);
+      });
+
+
   // --------------------------------------------------
   // Loading cell bindings from corgi library
   //py::object corgi_tile = (py::object) py::module::import("pycorgi").attr("Tile");
@@ -53,10 +99,26 @@ PYBIND11_MODULE(pyca, m) {
             >(m, "Tile")
     .def(py::init<>())
     .def("add_data",          &gol::Tile::add_data)
-    .def("get_data",          &gol::Tile::get_data)
+    .def("emplace_data",      &gol::Tile::emplace_data, py::arg("Nx"), py::arg("Ny"), py::arg("halo") = 1,
+        py::return_value_policy::reference_internal)
+    .def("get_data",          &gol::Tile::get_data, 
+        py::return_value_policy::reference_internal)
     .def("cycle",             &gol::Tile::cycle)
     .def("update_boundaries", &gol::Tile::update_boundaries);
 
+  py::class_<gol::BitTile, 
+            corgi::Tile<2>, 
+            std::shared_ptr<gol::BitTile>
+            >(m, "BitTile")
+    .def(py::init<>())
+    .def("add_data",          &gol::BitTile::add_data)
+    .def("emplace_data",      &gol::BitTile::emplace_data, py::arg("Nx"), py::arg("Ny"),
+        py::return_value_policy::reference_internal)
+    .def("get_data",          &gol::BitTile::get_data, 
+        py::return_value_policy::reference_internal)
+    .def("cycle",             &gol::BitTile::cycle)
+    .def("update_boundaries", &gol::BitTile::update_boundaries);
+
 
 
   // --------------------------------------------------
@@ -68,7 +130,25 @@ PYBIND11_MODULE(pyca, m) {
 
   py::class_<gol::Solver>(m, "Solver")
     .def(py::init<>())
-    .def("solve", &gol::Solver::solve);
+    .def_readwrite("block", &gol::Solver::block)
+    .def_readwrite("track_activity", &gol::Solver::track_activity)
+    .def("solve", &gol::Solver::solve, py::arg("tile"), py::arg("steps") = 1)
+    .def("solve_all", &gol::Solver::solve_all, py::arg("grid"), py::arg("steps") = 1,
+        py::call_guard<py::gil_scoped_release>());
+
+  py::class_<gol::BitSolver>(m, "BitSolver")
+    .def(py::init<>())
+    .def_readwrite("track_activity", &gol::BitSolver::track_activity)
+    .def("solve", &gol::BitSolver::solve)
+    .def("solve_all", &gol::BitSolver::solve_all, 
+        py::call_guard<py::gil_scoped_release>())
+    .def_static("simd", &gol::BitSolver::simd);
+
+  // batched versions of the tile methods; python cost does not scale with tiles
+  m.def("update_boundaries", &gol::update_boundaries, 
+      py::call_guard<py::gil_scoped_release>());
+  m.def("cycle", &gol::cycle, 
+      py::call_guard<py::gil_scoped_release>());
 
 }
 
@@ -153,11 +153,9 @@ def plotMesh(ax, n, conf):
         c = n.get_tile( cid )
         (i, j) = c.index
 
-        mesh = c.get_data()
-
-        for k in range(NyMesh):
-            for q in range(NxMesh):
-                data[ i*NxMesh + q, j*NyMesh + k ] = mesh[q,k]
+        # view to the mesh memory; strip halo regions
+        mesh = np.asarray( c.get_data() )
+        data[ i*NxMesh:(i+1)*NxMesh, j*NyMesh:(j+1)*NyMesh ] = mesh[1:-1, 1:-1]
 
 
     imshow(ax, data,
@@ -168,20 +168,10 @@ def plotNode(ax, n, conf, mpigrid=False):
         ax.set_title(str(len(virs))+"/"+str(len(boun))+"/"+str(len(locs)))
 
 def get_mpi_grid(n, conf):
-
-    tmp = np.ones( (n.get_Nx(), n.get_Ny()) ) * -1.0
-    for i in range(n.get_Nx()):
-        for j in range(n.get_Ny()):
-            tmp[i,j] = grid.get_mpi_grid(i,j)
-    return tmp
+    return n.get_mpi_grid_array().astype(float)
 
 def get_work_grid(n, conf):
-
-    tmp = np.ones( (n.get_Nx(), n.get_Ny()) ) * -1.0
-    for i in range(n.get_Nx()):
-        for j in range(n.get_Ny()):
-            tmp[i,j] = grid.get_work_grid(i,j)
-    return tmp
+    return n.get_work_grid_array()
 
 def analyze(n, f5, lap, conf):
 
@@ -172,22 +172,10 @@ def plotNode(ax, n, conf, mpigrid=False):
         ax.set_title(str(len(virs))+"/"+str(len(boun))+"/"+str(len(locs)))
 
 def get_mpi_grid(n, conf):
-
-    tmp = np.ones( (n.get_Nx(), n.get_Ny(), n.get_Nz()) ) * -1.0
-    for i in range(n.get_Nx()):
-        for j in range(n.get_Ny()):
-            for k in range(n.get_Nz()):
-                tmp[i,j,k] = grid.get_mpi_grid(i,j,k)
-    return tmp
+    return n.get_mpi_grid_array().astype(float)
 
 def get_work_grid(n, conf):
-
-    tmp = np.ones( (n.get_Nx(), n.get_Ny(), n.get_Nz()) ) * -1.0
-    for i in range(n.get_Nx()):
-        for j in range(n.get_Ny()):
-            for k in range(n.get_Nz()):
-                tmp[i,j,k] = grid.get_work_grid(i,j,k)
-    return tmp
+    return n.get_work_grid_array()
 
 def analyze(n, f5, lap, conf):
 
@@ -4,6 +4,8 @@
 #include <algorithm>
 
 #include <cassert>
+#include <cstring>
+#include <stdexcept>
 
 #include "container.h"
 #include "wrap.h"
@@ -13,42 +15,43 @@ using namespace prtcls;
 
 ParticleBlock::ParticleBlock(size_t Nx, size_t Ny, size_t Nz) :
   Nx(Nx), Ny(Ny), Nz(Nz)
-{ 
-  locArr.resize(3);
-  velArr.resize(3);
-}
+{ }
 
 
+void ParticleBlock::reallocate(size_t N)
+{
+  // component arrays stay cache-line aligned
+  const size_t cap = (N + 7) & ~size_t(7);
 
-void ParticleBlock::reserve(size_t N) {
-  for(size_t i=0; i<3; i++) locArr[i].reserve(N);
-  for(size_t i=0; i<3; i++) velArr[i].reserve(N);
-  wgtArr.reserve(N);
+  corgi::tools::aligned_vector<double> tmp(Ncomps*cap);
+  for(size_t c=0; c<Ncomps; c++) {
+    std::copy(comp(c), comp(c) + Nprtcls, tmp.data() + c*cap);
+  }
+  arena.swap(tmp);
+  capacity = cap;
 }
 
 
-void ParticleBlock::resize(size_t N)
+void ParticleBlock::grow(size_t N)
 {
-  for(size_t i=0; i<3; i++) locArr[i].resize(N);
-  for(size_t i=0; i<3; i++) velArr[i].resize(N);
-  wgtArr.resize(N);
-  Nprtcls = N;
+  if(N > capacity) reallocate( std::max(N, 2*capacity) );
 }
 
 
-size_t ParticleBlock::size() 
-{ 
-  // FIXME: these fail
-  //assert(locArr[0].size() == Nprtcls);
-  //assert(locArr[1].size() == Nprtcls);
-  //assert(locArr[2].size() == Nprtcls);
+void ParticleBlock::reserve(size_t N) {
+  if(N > capacity) reallocate(N);
+}
 
-  //assert(velArr[0].size() == Nprtcls);
-  //assert(velArr[1].size() == Nprtcls);
-  //assert(velArr[2].size() == Nprtcls);
 
-  //return Nprtcls; // FIXME: this is the correct way to return
-  return locArr[0].size();
+void ParticleBlock::resize(size_t N)
+{
+  if(N > capacity) grow(N);
+
+  // new particles are zero like in std::vector::resize
+  for(size_t c=0; c<Ncomps; c++) {
+    if(N > Nprtcls) std::fill(comp(c) + Nprtcls, comp(c) + N, 0.0);
+  }
+  Nprtcls = N;
 }
 
 
@@ -61,18 +64,41 @@ void ParticleBlock::add_particle (
   assert(prtcl_loc.size() == 3);
   assert(prtcl_vel.size() == 3);
 
-  for (size_t i=0; i<3; i++) locArr[i].push_back(prtcl_loc[i]);
-  for (size_t i=0; i<3; i++) velArr[i].push_back(prtcl_vel[i]);
-  wgtArr.push_back(prtcl_wgt);
+  add_particle(
+      prtcl_loc[0], prtcl_loc[1], prtcl_loc[2],
+      prtcl_vel[0], prtcl_vel[1], prtcl_vel[2],
+      prtcl_wgt);
+}
+
 
-  Nprtcls++;
+void ParticleBlock::add_particles(const Particle* prtcls, size_t n)
+{
+  if(Nprtcls + n > capacity) grow(Nprtcls + n);
+
+  for(size_t c=0; c<Ncomps; c++) {
+    double* dst = comp(c) + Nprtcls;
+    for(size_t i=0; i<n; i++) dst[i] = prtcls[i].data[c];
+  }
+  Nprtcls += n;
+}
+
+
+void ParticleBlock::add_particles(size_t n, const std::array<const double*, 7>& comps)
+{
+  if(Nprtcls + n > capacity) grow(Nprtcls + n);
+
+  for(size_t c=0; c<Ncomps; c++) {
+    std::copy(comps[c], comps[c] + n, comp(c) + Nprtcls);
+  }
+  Nprtcls += n;
 }
 
 void ParticleBlock::check_outgoing_particles(
     std::array<double,2>& mins,
     std::array<double,2>& maxs)
 {
-  to_other_tiles.clear();
+  const size_t N = size();
+  constexpr uint8_t stays = Ndirs;
 
   // unpack limits
   double 
@@ -85,226 +111,148 @@ void ParticleBlock::check_outgoing_particles(
     zmax = 1.0;
 
   // shortcut for particle locations
-  double* locn[3];
-  for( int i=0; i<3; i++) locn[i] = &( loc(i,0) );
+  const double* locn[3];
+  for( int i=0; i<3; i++) locn[i] = loc(i).data();
 
-  double x0, y0, z0;
+  std::array<size_t, Ndirs> counts = {};
+  outgoing_dirs.resize(N);
 
   int i,j,k; // relative indices
-  for(size_t n=0; n<size(); n++) {
-    i = 0;
-    j = 0;
-    k = 0;
-
-    x0 = locn[0][n];
-    y0 = locn[1][n];
-    z0 = locn[2][n];
-
-    if(x0 <  xmin) i--; // left wrap
-    if(x0 >= xmax) i++; // right wrap
+  for(size_t n=0; n<N; n++) {
+    const double x0 = locn[0][n];
+    const double y0 = locn[1][n];
+    const double z0 = locn[2][n];
+
+    i = (x0 >= xmax) - (x0 < xmin); // left/right wrap
+    j = (y0 >= ymax) - (y0 < ymin); // bottom/top wrap
+    k = (z0 >= zmax) - (z0 < zmin); // back/front
+
+    //TODO: hack to make this work with 2D corgi tiles
+    if ((i == 0) && (j == 0)) {
+      outgoing_dirs[n] = stays;
+      continue; 
+    }
 
-    if(y0 <  ymin) j--; // bottom wrap
-    if(y0 >= ymax) j++; // top wrap
+    const int b = dir_index(i,j,k);
+    outgoing_dirs[n] = static_cast<uint8_t>(b);
+    counts[b]++;
+  }
 
-    if(z0 <  zmin) k--; // back
-    if(z0 >= zmax) k++; // front
+  // counting sort; indices stay ascending within a bucket
+  outgoing_offsets[0] = 0;
+  for(int b=0; b<Ndirs; b++) outgoing_offsets[b+1] = outgoing_offsets[b] + counts[b];
 
-    if ((i == 0) && (j == 0)) continue; //TODO: hack to make this work with 2D corgi tiles
+  outgoing_indices.resize( outgoing_offsets[Ndirs] );
+  std::array<size_t, Ndirs> pos;
+  std::copy(outgoing_offsets.begin(), outgoing_offsets.end()-1, pos.begin());
 
-    //if ( (i != 0) | (j != 0) | (k != 0) ) {
-      
-    // TODO: another 2D hack
-    if ( (i != 0) || (j != 0) ) { 
-      to_other_tiles.insert( 
-          std::make_pair( std::make_tuple(i,j,k), n) );
-    }
+  for(size_t n=0; n<N; n++) {
+    const uint8_t b = outgoing_dirs[n];
+    if(b != stays) outgoing_indices[ pos[b]++ ] = static_cast<int>(n);
   }
 }
 
 
 void ParticleBlock::delete_transferred_particles()
 {
-  std::vector<int> to_be_deleted;
-
-  //for(auto& elem : container.to_other_tiles)  {
-  //  std::cout << "to be removed particle # " 
-  //            << elem.second << " ";
-  //  std::cout << "(" 
-  //            << std::get<0>(elem.first) 
-  //            << "," << std::get<1>(elem.first) 
-  //            << "," << std::get<2>(elem.first) 
-  //            << ")";
-  //  std::cout << '\n';
-  //}
-
-  // get and reverse sort deleted particles
-  for(auto& elem : to_other_tiles) to_be_deleted.push_back( elem.second );
-  std::sort(to_be_deleted.begin(), to_be_deleted.end(), std::greater<int>() );
-
-  double* locn[3];
-  for( int i=0; i<3; i++) locn[i] = &( loc(i,0) );
-
-  double* veln[3];
-  for( int i=0; i<3; i++) veln[i] = &( vel(i,0) );
-
-  // overwrite particles with the last one on the array and 
-  // then resize the array
-  int last = size();
-  for(int indx : to_be_deleted) {
-    last--;
-    //std::cout << "deleting " << indx 
-    //          << " by putting it to " << last << '\n';
-    for(int i=0; i<3; i++) locn[i][indx] = locn[i][last];
-    for(int i=0; i<3; i++) veln[i][indx] = veln[i][last];
-    wgtArr[indx] = wgtArr[last];
+  if(outgoing_indices.empty()) return;
+
+  const size_t N = size();
+  const size_t Nchecked = std::min(outgoing_dirs.size(), N);
+  constexpr uint8_t stays = Ndirs;
+
+  // first leaving particle; everything before it stays in place
+  size_t first = 0;
+  while(first < Nchecked && outgoing_dirs[first] == stays) first++;
+
+  // compact every component (branch-free: always write, advance if kept);
+  // particles appended after the check stay
+  size_t last = first;
+  for(size_t c=0; c<Ncomps; c++) {
+    double* x = comp(c);
+    last = first;
+    for(size_t n=first; n<Nchecked; n++) {
+      x[last] = x[n];
+      last += (outgoing_dirs[n] == stays);
+    }
+    for(size_t n=Nchecked; n<N; n++) x[last++] = x[n];
   }
 
-  // resize if needed and take care of the size
-  last = last < 0 ? 0 : last;
-  if ((last != (int)size()) && (size() > 0)) resize(last);
+  resize(last);
+  outgoing_dirs.clear();
+  outgoing_indices.clear();
+  outgoing_offsets.fill(0);
 }
 
 
 void ParticleBlock::transfer_and_wrap_particles( 
-    ParticleBlock& neigh,
+    const ParticleBlock& neigh,
     std::array<int,3>     dirs, 
-    std::array<double,3>& mins, 
-    std::array<double,3>& maxs
+    const std::array<double,3>& mins, 
+    const std::array<double,3>& maxs
     )
 {
-  double locx, locy, locz, velx, vely, velz, wgt;
-  int ind;
-
-  for (auto&& elem : neigh.to_other_tiles) {
-      
-    //TODO: collapsed z-dimension due to 2D corgi tiles
-    if (std::get<0>(elem.first) == 0 &&
-        std::get<1>(elem.first) == 0 ) 
-    { continue; }
-
-    // NOTE: directions are flipped (- sign) so that they are
-    // in directions in respect to the current tile
-    if (std::get<0>(elem.first) == -dirs[0] &&
-        std::get<1>(elem.first) == -dirs[1] ) {
-
-      ind = elem.second;
-
-      locx = wrap( neigh.loc(0, ind), mins[0], maxs[0] );
-      locy = wrap( neigh.loc(1, ind), mins[1], maxs[1] );
-      locz = wrap( neigh.loc(2, ind), mins[2], maxs[2] );
-
-      velx = neigh.vel(0, ind);
-      vely = neigh.vel(1, ind);
-      velz = neigh.vel(2, ind);
-
-      wgt  = neigh.wgt(ind);
-
-      add_particle({locx,locy,locz}, {velx,vely,velz}, wgt);
-    }
-  }
-
+  //TODO: collapsed z-dimension due to 2D corgi tiles
+  if (dirs[0] == 0 && dirs[1] == 0) return;
+
+  // NOTE: directions are flipped (- sign) so that they are
+  // in directions in respect to the current tile
+  const auto inds = neigh.outgoing(-dirs[0], -dirs[1]);
+  if(Nprtcls + inds.size() > capacity) grow(Nprtcls + inds.size());
+
+  for(int ind : inds) {
+    add_particle(
+      wrap( neigh.loc(0, ind), mins[0], maxs[0] ),
+      wrap( neigh.loc(1, ind), mins[1], maxs[1] ),
+      wrap( neigh.loc(2, ind), mins[2], maxs[2] ),
+      neigh.vel(0, ind),
+      neigh.vel(1, ind),
+      neigh.vel(2, ind),
+      neigh.wgt(ind));
   }
+}
 
-void ParticleBlock::pack_outgoing_particles()
+void ParticleBlock::pack_particles(
+    std::vector<char>& buf, 
+    const std::vector<span<const int>>& lists) const
 {
-  outgoing_particles.clear();
-  outgoing_extra_particles.clear();
-    
-  // +1 for info particle
-  int np = to_other_tiles.size() + 1;
-  InfoParticle infoprtcl(np);
-
-  //if (np>1) {
-  //  std::cout << "Packing Np:" << np 
-  //    << " and extra is: " << np-optimal_message_size << "\n";
-  //}
-
-  outgoing_particles.reserve(optimal_message_size);
-  if (np-optimal_message_size > 0) {
-    std::cout << "EXTRA send with " << np-optimal_message_size << "\n";
-    outgoing_extra_particles.reserve( np-optimal_message_size);
-  }
-
-  // first particle is always the message info
-  outgoing_particles.push_back(infoprtcl);
-
-  // next, pack all other particles
-  int i=1, ind;
-  for (auto&& elem : to_other_tiles) {
-    ind = elem.second;
-
-    if(i < optimal_message_size) {
-      outgoing_particles.emplace_back( 
-        loc(0, ind), loc(1, ind), loc(2, ind), 
-        vel(0, ind), vel(1, ind), vel(2, ind), 
-        wgt(ind));
-    } else {
-      outgoing_extra_particles.emplace_back( 
-        loc(0, ind), loc(1, ind), loc(2, ind), 
-        vel(0, ind), vel(1, ind), vel(2, ind), 
-        wgt(ind));
+  size_t np = 0;
+  for(const auto& inds : lists) np += inds.size();
+
+  size_t off = buf.size();
+  buf.resize(off + Ncomps*np*sizeof(double));
+
+  for(size_t c=0; c<Ncomps; c++) {
+    const double* x = comp(c);
+    for(const auto& inds : lists) {
+      for(int ind : inds) {
+        std::memcpy(buf.data() + off, x + ind, sizeof(double));
+        off += sizeof(double);
+      }
     }
-
-    i++;
-  }
-
-  // TODO: set next message size dynamically according to history
-  //optimal_message_size = np;
-
   }
+}
 
 
-void ParticleBlock::unpack_incoming_particles()
+size_t ParticleBlock::unpack_particles(const char* buf, size_t size, size_t np)
 {
-  double locx, locy, locz, velx, vely, velz, wgt;
-
-  // get real number of incoming particles
-  InfoParticle msginfo(incoming_particles[0]);
-  int number_of_incoming_particles = msginfo.size();
-
-  int number_of_primary_particles = 
-    number_of_incoming_particles > optimal_message_size 
-    ? optimal_message_size : number_of_incoming_particles;
-
-  int number_of_secondary_particles = incoming_extra_particles.size();
-
-  //if (number_of_incoming_particles > 1) {
-  //  std::cout << "unpacking Np:" << number_of_incoming_particles
-  //    << " /+ " << number_of_primary_particles << "/"
-  //    << number_of_secondary_particles << "\n";
-  //}
+  if(np > size/(Ncomps*sizeof(double))) throw std::length_error("prtcls: truncated particle message");
+  const size_t bytes = Ncomps*np*sizeof(double);
 
-  // skipping 1st info particle
-  for(int i=1; i<number_of_primary_particles; i++){
-    locx = incoming_particles[i].x();
-    locy = incoming_particles[i].y();
-    locz = incoming_particles[i].z();
+  if(Nprtcls + np > capacity) grow(Nprtcls + np);
 
-    velx = incoming_particles[i].ux();
-    vely = incoming_particles[i].uy();
-    velz = incoming_particles[i].uz();
-    wgt  = incoming_particles[i].wgt();
-
-    add_particle({locx,locy,locz}, {velx,vely,velz}, wgt);
+  const char* p = buf;
+  for(size_t c=0; c<Ncomps; c++) {
+    std::memcpy(comp(c) + Nprtcls, p, np*sizeof(double));
+    p += np*sizeof(double);
   }
+  Nprtcls += np;
 
-  for(int i=0; i<number_of_secondary_particles; i++){
-    locx = incoming_extra_particles[i].x();
-    locy = incoming_extra_particles[i].y();
-    locz = incoming_extra_particles[i].z();
-
-    velx = incoming_extra_particles[i].ux();
-    vely = incoming_extra_particles[i].uy();
-    velz = incoming_extra_particles[i].uz();
-    wgt  = incoming_extra_particles[i].wgt();
-
-    add_particle({locx,locy,locz}, {velx,vely,velz}, wgt);
-  }
-
-  }
+  return bytes;
+}
 
 
-inline Particle::Particle(double x, double y, double z,
+Particle::Particle(double x, double y, double z,
                    double ux, double uy, double uz, 
                    double wgt)
 {
@@ -2,7 +2,9 @@
 
 #include <array>
 #include <vector>
-#include <map>
+#include <cstdint>
+
+#include "corgi/toolbox/aligned_allocator.h"
 
 
 namespace prtcls {
@@ -30,72 +32,100 @@ public:
 };
 
 
-/// Special handling of particle MPI message info 
-// via this auxiliary helper class
-class InfoParticle : public Particle
+/// Non-owning view to a contiguous array
+template<typename T>
+class span
 {
-public:
+  T* _ptr = nullptr;
+  size_t _size = 0;
 
-  InfoParticle(size_t np) 
-    : Particle(
-        static_cast<double>(np), 0,0,
-        0,0,0,
-        0) {}
+  public:
 
-  InfoParticle(Particle& prtcl) {
-    data[0] = prtcl.x();
-  }
+  span() = default;
+  span(T* ptr, size_t size) : _ptr(ptr), _size(size) {}
 
-  size_t size() {return static_cast<size_t>(Particle::x());}
+  T* data() const { return _ptr; }
+  size_t size() const { return _size; }
+  bool empty() const { return _size == 0; }
 
-private:
-  using Particle::x;
-  using Particle::y;
-  using Particle::z;
-  using Particle::ux;
-  using Particle::uy;
-  using Particle::uz;
-  using Particle::wgt;
+  T& operator [] (size_t i) const { return _ptr[i]; }
 
+  T* begin() const { return _ptr; }
+  T* end()   const { return _ptr + _size; }
 };
 
 
-
-
+/// Particle storage as structure of arrays
+//
+// All 7 components (x,y,z,ux,uy,uz,wgt) live in one aligned arena:
+// component c occupies [c*capacity, c*capacity + size) so every
+// component array starts at a cache line. Growing the container
+// reallocates the arena, which invalidates all spans and pointers.
 class ParticleBlock 
 {
 
   //--------------------------------------------------
   protected:
 
-  size_t Nprtcls;
+  static constexpr size_t Ncomps = 7;
 
-  std::vector< std::vector<double> > locArr;
-  std::vector< std::vector<double> > velArr;
-  std::vector<double> wgtArr;
+  size_t Nprtcls = 0;
 
-  public:
+  /// particles per component array (multiple of 8 doubles = 64 bytes)
+  size_t capacity = 0;
+
+  corgi::tools::aligned_vector<double> arena;
+
+  double* comp(size_t c) { return arena.data() + c*capacity; }
+  const double* comp(size_t c) const { return arena.data() + c*capacity; }
 
-  /// packed outgoing particles
-  std::vector<Particle> outgoing_particles;
-  std::vector<Particle> outgoing_extra_particles;
-  void pack_outgoing_particles();
+  /// move the arena to a capacity of N particles (N >= size)
+  void reallocate(size_t N);
 
-  /// packed incoming particles
-  std::vector<Particle> incoming_particles;
-  std::vector<Particle> incoming_extra_particles;
-  void unpack_incoming_particles();
+  /// grow capacity to at least N (geometrically)
+  void grow(size_t N);
 
-  /// dynamic message size that traces the optimal
-  // message length (i.e., number of particles) hand 
-  // in hand with the corresponding receiver side.
-  int optimal_message_size = 10;
+  public:
+
+  //--------------------------------------------------
 
   //--------------------------------------------------
+  // particles going to other tiles
+
+  /// direction (i,j,k) of a leaving particle is bucket 9(i+1) + 3(j+1) + (k+1)
+  static constexpr int Ndirs = 27;
+
+  static constexpr int dir_index(int i, int j, int k) { return 9*(i+1) + 3*(j+1) + (k+1); }
+
+  protected:
+
+  /// bucket of every particle at the last check_outgoing_particles (stays if >= Ndirs)
+  std::vector<uint8_t> outgoing_dirs;
+
+  /// indices of leaving particles by bucket; ascending within a bucket
+  std::vector<int> outgoing_indices;
+
+  /// bucket b is outgoing_indices[outgoing_offsets[b] .. outgoing_offsets[b+1])
+  std::array<size_t, Ndirs+1> outgoing_offsets = {};
+
+  public:
+
+  /// all leaving particles in the order of their buckets
+  span<const int> outgoing() const { return { outgoing_indices.data(), outgoing_indices.size() }; }
+
+  /// particles leaving to direction (i,j,k)
+  span<const int> outgoing(int i, int j, int k) const
+  {
+    const int b = dir_index(i,j,k);
+    return { outgoing_indices.data() + outgoing_offsets[b], outgoing_offsets[b+1] - outgoing_offsets[b] };
+  }
 
-  //! multimap of particles going to other tiles
-  typedef std::multimap<std::tuple<int,int,int>, int> mapType;
-  mapType to_other_tiles;
+  /// particles leaving to (i,j) with any k; the three buckets are adjacent
+  span<const int> outgoing(int i, int j) const
+  {
+    const int b = dir_index(i,j,-1);
+    return { outgoing_indices.data() + outgoing_offsets[b], outgoing_offsets[b+3] - outgoing_offsets[b] };
+  }
 
 
 
@@ -120,57 +150,72 @@ class ParticleBlock
   virtual void resize(size_t N);
 
   /// size of the container (in terms of particles)
-  size_t size();
+  size_t size() const { return Nprtcls; }
 
   //--------------------------------------------------
   // locations
   virtual inline double loc( size_t idim, size_t iprtcl ) const
   {
-    return locArr[idim][iprtcl];
+    return comp(idim)[iprtcl];
   }
 
   virtual inline double& loc( size_t idim, size_t iprtcl )       
   {
-    return locArr[idim][iprtcl];
+    return comp(idim)[iprtcl];
+  }
+
+  virtual inline span<double> loc(size_t idim) 
+  {
+    return { comp(idim), Nprtcls };
   }
 
-  virtual inline std::vector<double>& loc(size_t idim) 
+  virtual inline span<const double> loc(size_t idim) const
   {
-    return locArr[idim];
+    return { comp(idim), Nprtcls };
   }
 
   //--------------------------------------------------
   // velocities
   virtual inline double vel( size_t idim, size_t iprtcl ) const
   {
-    return velArr[idim][iprtcl];
+    return comp(3+idim)[iprtcl];
   }
 
   virtual inline double& vel( size_t idim, size_t iprtcl )       
   {
-    return velArr[idim][iprtcl];
+    return comp(3+idim)[iprtcl];
+  }
+
+  virtual inline span<double> vel(size_t idim) 
+  {
+    return { comp(3+idim), Nprtcls };
   }
 
-  virtual inline std::vector<double>& vel(size_t idim) 
+  virtual inline span<const double> vel(size_t idim) const
   {
-    return velArr[idim];
+    return { comp(3+idim), Nprtcls };
   }
 
   //--------------------------------------------------
   // weights
   virtual inline double wgt( size_t iprtcl ) const
   {
-    return wgtArr[iprtcl];
+    return comp(6)[iprtcl];
   }
 
   virtual inline double& wgt( size_t iprtcl )       
   {
-    return wgtArr[iprtcl];
+    return comp(6)[iprtcl];
   }
 
-  virtual inline std::vector<double>& wgt() 
+  virtual inline span<double> wgt() 
   {
-    return wgtArr;
+    return { comp(6), Nprtcls };
+  }
+
+  virtual inline span<const double> wgt() const
+  {
+    return { comp(6), Nprtcls };
   }
 
   // --------------------------------------------------
@@ -181,25 +226,66 @@ class ParticleBlock
       std::vector<double> prtcl_vel,
       double prtcl_wgt);
 
+  /// append one particle without temporaries
+  inline void add_particle(
+      double x,  double y,  double z,
+      double ux, double uy, double uz,
+      double w)
+  {
+    if(Nprtcls == capacity) grow(Nprtcls + 1);
+
+    const size_t n = Nprtcls++;
+    comp(0)[n] = x;  comp(1)[n] = y;  comp(2)[n] = z;
+    comp(3)[n] = ux; comp(4)[n] = uy; comp(5)[n] = uz;
+    comp(6)[n] = w;
+  }
+
+  /// append n packed particles
+  void add_particles(const Particle* prtcls, size_t n);
+
+  /// append n particles given as component arrays (x,y,z,ux,uy,uz,wgt)
+  void add_particles(size_t n, const std::array<const double*, 7>& comps);
+
+  // --------------------------------------------------
+  // messages
+
+  /// append the particles of the index lists to buf
+  //
+  // Layout: the 7 component arrays (x,y,z,ux,uy,uz,wgt) gathered straight
+  // from the arena. The particle count is not included; the caller sends
+  // it separately (see Tile::pack_header).
+  void pack_particles(std::vector<char>& buf, const std::vector<span<const int>>& lists) const;
+
+  /// append np particles of a message written by pack_particles; returns the bytes read
+  size_t unpack_particles(const char* buf, size_t size, size_t np);
+
   // --------------------------------------------------
 
   /// check and mark particles exceeding given limits
+  //
+  // Leaving particles are binned into direction buckets with a counting
+  // sort (two linear passes).
   void check_outgoing_particles(
       std::array<double,2>& /*mins*/,
       std::array<double,2>&  /*maxs*/);
 
 
   /// delete particles that went beyond boundaries, i.e.,
-  // ended up in to_other_tiles box
+  // ended up in an outgoing bucket
+  //
+  // One compaction pass; the remaining particles keep their order.
+  // Particles added after check_outgoing_particles are kept.
   void delete_transferred_particles();
 
 
   /// transfer particles between blocks
+  //
+  // neigh is only read so that several blocks can pull from it concurrently.
   void transfer_and_wrap_particles(
-      ParticleBlock& /*neigh*/, 
+      const ParticleBlock& /*neigh*/, 
       std::array<int,3> /*dirs*/,
-      std::array<double,3>& /*mins*/,
-      std::array<double,3>& /*maxs*/);
+      const std::array<double,3>& /*mins*/,
+      const std::array<double,3>& /*maxs*/);
 
 };
 
@@ -186,16 +186,17 @@ def get_particles(grid, conf, ip):
 
 
 def get_particles_from_tile(tile, ispcs):
+    # numpy views; valid until the container is modified
     container = tile.get_container(ispcs)
-    x  = container.loc(0)
-    y  = container.loc(1)
-    z  = container.loc(2)
+    x  = container.loc_array(0)
+    y  = container.loc_array(1)
+    z  = container.loc_array(2)
 
-    ux = container.vel(0)
-    uy = container.vel(1)
-    uz = container.vel(2)
+    ux = container.vel_array(0)
+    uy = container.vel_array(1)
+    uz = container.vel_array(2)
 
-    wgt = container.wgt()
+    wgt = container.wgt_array()
 
     return x, y, z, ux, uy, uz, wgt
 
@@ -281,6 +282,10 @@ def initialize_tile(c, i, j, n, conf):
     c.set_tile_mins(mins[0:2])
     c.set_tile_maxs(maxs[0:2])
 
+    #global limits for periodic wrapping of incoming particles
+    c.grid_mins = [n.get_xmin(), n.get_ymin(), 0.0]
+    c.grid_maxs = [n.get_xmax(), n.get_ymax(), 1.0]
+
 
 #load tiles into each grid
 def load_tiles(n, conf):
@@ -421,6 +426,9 @@ if __name__ == "__main__":
     
     grid = pycorgi.twoD.Grid( conf.Nx, conf.Ny ) 
     grid.set_grid_lims(conf.xmin, conf.xmax, conf.ymin, conf.ymax)
+
+    # particles are packed per destination and sized with MPI_Mprobe
+    grid.set_codec(0, pycorgi.CopyCodec())
     
     loadMpiRandomly(grid)
     #loadMpiXStrides(grid)
@@ -454,9 +462,7 @@ if __name__ == "__main__":
             saveVisz(lap, grid, conf)
     
         #move particles
-        for cid in grid.get_local_tiles():
-            tile = grid.get_tile(cid)
-            pusher.solve(tile)
+        pusher.solve_all(grid)
 
 
         ################################################## 
@@ -467,33 +473,18 @@ if __name__ == "__main__":
             tile = grid.get_tile(cid)
             tile.check_outgoing_particles()
 
-        # global mpi exchange (independent)
-        for cid in grid.get_boundary_tiles():
-            tile = grid.get_tile(cid)
-            tile.pack_outgoing_particles()
-
-        # MPI global exchange
-        # transfer primary and extra data
-        grid.send_data(0) #(indepdendent)
-        grid.send_data(1) #(indepdendent)
-
-        grid.recv_data(0) #(indepdendent)
-        grid.recv_data(1) #(indepdendent)
-
-        grid.wait_data(0) #(indepdendent)
-        grid.wait_data(1) #(indepdendent)
+        # MPI global exchange; boundary tiles are packed and the 
+        # received particles appended to the virtual tiles in one round
+        grid.exchange_data(0)
 
 
-        # global unpacking (independent)
+        # global binning of the received particles (independent)
         for cid in grid.get_virtual_tiles(): 
             tile = grid.get_tile(cid)
-            tile.unpack_incoming_particles()
             tile.check_outgoing_particles()
 
-        # transfer local + global
-        for cid in grid.get_local_tiles():
-            tile = grid.get_tile(cid)
-            tile.get_incoming_particles(grid)
+        # transfer local + global (threaded over tiles)
+        grid.pairwise_moore_communication(0)
 
         # delete local transferred particles
         for cid in grid.get_local_tiles():
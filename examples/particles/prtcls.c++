@@ -1,6 +1,12 @@
 #include <string>
 #include <array>
 #include <cmath>
+#include <cstring>
+#include <stdexcept>
+
+#if defined(__AVX2__) || defined(__AVX512F__)
+#include <immintrin.h>
+#endif
 
 #include "prtcls.h"
 #include "container.h"
@@ -65,172 +71,102 @@ void Tile::get_incoming_particles(
   }
 
 
-// create MPI tag given tile id and extra layer of differentiation
-int get_tag(int tag, int extra_param)
-{
-  assert(extra_param <= 8); // max 8 species
-  assert(tag < (pow(2,16) - 1)); // cray-mpich supports maximum of 2^22-1 tag value
-
-  return tag + (9+extra_param)*pow(2,16);
-}
-
-// create MPI tag for extra communication given tile 
-// id and extra layer of differentiation
-int get_extra_tag(int tag, int extra_param)
-{
-  assert(extra_param <= 8); // max 8 species
-  assert(tag < (pow(2,16) - 1)); // cray-mpich supports maximum of 2^22-1 tag value
-
-  return tag + (9+8+extra_param)*pow(2,16);
-}
-
-
-std::vector<mpi4cpp::mpi::request> Tile::send_data( 
-    mpi4cpp::mpi::communicator& comm, 
-    int dest, 
-    int mode,
-    int tag)
+void Tile::pairwise_moore_communication(
+    const corgi::Tile<2>& other,
+    const std::array<int, 2> dir_to_other,
+    const int /*mode*/)
 {
-  if (mode == 0) {
-      return Tile::send_particle_data(comm, dest, tag);
-  } else if(mode == 1) {
-      return Tile::send_particle_extra_data(comm,dest, tag);
-  } else {
-      assert(false);
-      exit(1);
-  }
-}
+  const Tile& external_tile = dynamic_cast<const Tile&>(other);
 
-std::vector<mpi4cpp::mpi::request> Tile::send_particle_data( 
-    mpi4cpp::mpi::communicator& comm, 
-    int dest,
-    int tag)
-{
-  std::vector<mpi4cpp::mpi::request> reqs;
   for(size_t ispc=0; ispc<Nspecies(); ispc++) {
     ParticleBlock& container = get_container(ispc);
+    const ParticleBlock& neigh = external_tile.containers[ispc];
 
-    reqs.push_back(
-        comm.isend(dest, get_tag(tag, ispc), 
-          container.outgoing_particles.data(), 
-          container.outgoing_particles.size())
-        );
+    container.transfer_and_wrap_particles(
+        neigh, {dir_to_other[0], dir_to_other[1], 0}, grid_mins, grid_maxs);
   }
-
-  return reqs;
 }
 
 
-std::vector<mpi4cpp::mpi::request> Tile::send_particle_extra_data( 
-    mpi4cpp::mpi::communicator& comm, 
-    int dest,
-    int tag)
+std::vector<mpi4cpp::mpi::request> Tile::send_data( 
+    mpi4cpp::mpi::communicator& /*comm*/, 
+    int /*dest*/, 
+    int /*mode*/,
+    int /*tag*/)
 {
-  std::vector<mpi4cpp::mpi::request> reqs;
-  for(size_t ispc=0; ispc<Nspecies(); ispc++) {
-    ParticleBlock& container = get_container(ispc);
-
-    if(!container.outgoing_extra_particles.empty()) {
-      reqs.push_back(
-          comm.isend(dest, get_extra_tag(tag, ispc), 
-            container.outgoing_extra_particles.data(), 
-            container.outgoing_extra_particles.size())
-          );
-    }
-  }
-  return reqs;
+  throw std::logic_error("prtcls::Tile: set a codec (e.g., CopyCodec) for particle modes");
 }
 
 
 std::vector<mpi4cpp::mpi::request> Tile::recv_data( 
-    mpi4cpp::mpi::communicator& comm, 
-    int orig, 
-    int mode,
-    int tag)
+    mpi4cpp::mpi::communicator& /*comm*/, 
+    int /*orig*/, 
+    int /*mode*/,
+    int /*tag*/)
 {
-  if(mode == 0) {
-      return Tile::recv_particle_data(comm,orig,tag);
-  } else if(mode == 1) {
-      return Tile::recv_particle_extra_data(comm,orig,tag);
-  } else { 
-      assert(false);
-      exit(1);
-  }
+  throw std::logic_error("prtcls::Tile: set a codec (e.g., CopyCodec) for particle modes");
 }
 
 
-std::vector<mpi4cpp::mpi::request> Tile::recv_particle_data( 
-    mpi4cpp::mpi::communicator& comm, 
-    int orig,
-    int tag)
-{
-  std::vector<mpi4cpp::mpi::request> reqs;
-  for (size_t ispc=0; ispc<Nspecies(); ispc++) {
-    ParticleBlock& container = get_container(ispc);
-    container.incoming_particles.resize( container.optimal_message_size );
+namespace {
 
-    reqs.push_back(
-        comm.irecv(orig, get_tag(tag, ispc),
-          container.incoming_particles.data(),
-          container.optimal_message_size)
-        );
+/// outgoing buckets of a container facing the tiles that dest owns
+void outgoing_lists(
+    const ParticleBlock& container,
+    const corgi::Tile<2>& tile,
+    int dest,
+    std::vector<span<const int>>& lists)
+{
+  lists.clear();
+  auto it = tile.halo_directions.find(dest);
+  if(it != tile.halo_directions.end()) {
+    for(auto& [in, jn] : it->second) lists.push_back( container.outgoing(in, jn) );
   }
+}
 
-  return reqs;
 }
 
 
-std::vector<mpi4cpp::mpi::request> Tile::recv_particle_extra_data( 
-    mpi4cpp::mpi::communicator& comm, 
-    int orig,
-    int tag)
+void Tile::pack_header(std::vector<char>& buf, int dest, int /*mode*/)
 {
-  std::vector<mpi4cpp::mpi::request> reqs;
-
-  // this assumes that wait for the first message is already called
-  // and passed.
+  std::vector<span<const int>> lists;
 
-  int extra_size;
-  for (size_t ispc=0; ispc<Nspecies(); ispc++) {
-    ParticleBlock& container = get_container(ispc);
-    InfoParticle msginfo(container.incoming_particles[0]);
-
-    // check if we need to expect extra message
-    extra_size = msginfo.size() - container.optimal_message_size;
-    if(extra_size > 0) {
-      container.incoming_extra_particles.resize(extra_size);
-
-      reqs.push_back(
-          comm.irecv(orig, get_extra_tag(tag, ispc),
-            container.incoming_extra_particles.data(),
-            extra_size)
-          );
-    } else {
-      container.incoming_extra_particles.clear();
-    }
+  for(auto&& container : containers) {
+    outgoing_lists(container, *this, dest, lists);
 
-    //TODO: dynamic optimal_message_size here
-    //container.optimal_message_size = msginfo.size();
+    uint64_t np = 0;
+    for(const auto& inds : lists) np += inds.size();
 
+    const size_t off = buf.size();
+    buf.resize(off + sizeof(uint64_t));
+    std::memcpy(buf.data() + off, &np, sizeof(uint64_t));
   }
-
-  return reqs;
 }
 
 
-void Tile::pack_outgoing_particles()
+void Tile::pack_data(std::vector<char>& buf, int dest, int /*mode*/)
 {
+  // only the buckets facing tiles that dest owns
+  std::vector<span<const int>> lists;
+
   for(auto&& container : containers) {
-    container.pack_outgoing_particles();
+    outgoing_lists(container, *this, dest, lists);
+    container.pack_particles(buf, lists);
   }
 }
 
 
-void Tile::unpack_incoming_particles()
+void Tile::unpack_data(const char* buf, size_t size, int /*orig*/, int /*mode*/)
 {
-  for(auto&& container : containers) {
-    container.unpack_incoming_particles();
+  size_t off = containers.size()*sizeof(uint64_t);
+  if(size < off) throw std::length_error("prtcls: truncated particle message");
+
+  for(size_t s=0; s<containers.size(); s++) {
+    uint64_t np = 0;
+    std::memcpy(&np, buf + s*sizeof(uint64_t), sizeof(uint64_t));
+    off += containers[s].unpack_particles(buf + off, size - off, np);
   }
+  if(off != size) throw std::length_error("prtcls: particle message size mismatch");
 }
 
 
@@ -243,43 +179,148 @@ void Tile::delete_all_particles()
 
 
 
-void Pusher::solve(Tile& tile) 
+// --------------------------------------------------
+// Pusher kernel
+//
+// Relativistic position update x += u g c with g = c/sqrt(c^2 + (c u)^2).
+// The kernel is written once for a set of vector operations and compiled
+// for scalars, AVX2 (4 doubles), and AVX-512 (8 doubles); the widest
+// available one is chosen at compile time (e.g., -march=native) and the
+// remainder is pushed with the scalar version. All versions evaluate the
+// same operations in the same order (no fused multiply-adds), so results
+// are identical.
+
+namespace {
+
+struct scalar_ops {
+  using V = double;
+  static constexpr int width = 1;
+
+  static V load(const double* p) { return *p; }
+  static void store(double* p, V x) { *p = x; }
+  static V set1(double x) { return x; }
+
+  static V add(V a, V b) { return a + b; }
+  static V mul(V a, V b) { return a * b; }
+  static V div(V a, V b) { return a / b; }
+  static V sqrt(V a) { return std::sqrt(a); }
+};
+
+
+#if defined(__AVX2__)
+struct avx2_ops {
+  using V = __m256d;
+  static constexpr int width = 4;
+
+  static V load(const double* p) { return _mm256_loadu_pd(p); }
+  static void store(double* p, V x) { _mm256_storeu_pd(p, x); }
+  static V set1(double x) { return _mm256_set1_pd(x); }
+
+  static V add(V a, V b) { return _mm256_add_pd(a, b); }
+  static V mul(V a, V b) { return _mm256_mul_pd(a, b); }
+  static V div(V a, V b) { return _mm256_div_pd(a, b); }
+  static V sqrt(V a) { return _mm256_sqrt_pd(a); }
+};
+#endif
+
+
+#if defined(__AVX512F__)
+struct avx512_ops {
+  using V = __m512d;
+  static constexpr int width = 8;
+
+  static V load(const double* p) { return _mm512_loadu_pd(p); }
+  static void store(double* p, V x) { _mm512_storeu_pd(p, x); }
+  static V set1(double x) { return _mm512_set1_pd(x); }
+
+  static V add(V a, V b) { return _mm512_add_pd(a, b); }
+  static V mul(V a, V b) { return _mm512_mul_pd(a, b); }
+  static V div(V a, V b) { return _mm512_div_pd(a, b); }
+  static V sqrt(V a) { return _mm512_sqrt_pd(a); }
+};
+#endif
+
+
+/// push particles [n, N); returns the first particle not done
+template<class Ops>
+size_t push_particles(
+    double* const loc[3], const double* const vel[3],
+    const double c,
+    size_t n, const size_t N)
 {
-  for(auto&& container : tile.containers) {
-    int nparts = container.size();
+  using V = typename Ops::V;
+  const V cv  = Ops::set1(c);
+  const V cc  = Ops::set1(c*c);
+
+  for(; n + Ops::width <= N; n += Ops::width) {
+    const V vx = Ops::load(vel[0] + n);
+    const V vy = Ops::load(vel[1] + n);
+    const V vz = Ops::load(vel[2] + n);
+
+    const V u0 = Ops::mul(cv, vx);
+    const V v0 = Ops::mul(cv, vy);
+    const V w0 = Ops::mul(cv, vz);
+
+    // position advance
+    const V u2 = Ops::add( Ops::add( Ops::add(cc, Ops::mul(u0, u0)), Ops::mul(v0, v0)), Ops::mul(w0, w0) );
+    const V g  = Ops::div(cv, Ops::sqrt(u2));
+
+    Ops::store(loc[0] + n, Ops::add( Ops::load(loc[0] + n), Ops::mul( Ops::mul(vx, g), cv) ));
+    Ops::store(loc[1] + n, Ops::add( Ops::load(loc[1] + n), Ops::mul( Ops::mul(vy, g), cv) ));
+    Ops::store(loc[2] + n, Ops::add( Ops::load(loc[2] + n), Ops::mul( Ops::mul(vz, g), cv) ));
+  }
 
-    // initialize pointers to particle arrays
-    double* loc[3];
-    for( int i=0; i<3; i++)
-      loc[i] = &( container.loc(i,0) );
+  return n;
+}
 
-    double* vel[3];
-    for( int i=0; i<3; i++)
-      vel[i] = &( container.vel(i,0) );
+} // end of anonymous namespace
 
 
-    // loop over particles
-    int n1 = 0;
-    int n2 = nparts;
+void Pusher::solve(ParticleBlock& container) 
+{
+  const size_t nparts = container.size();
+
+  // initialize pointers to particle arrays
+  double* loc[3];
+  for( int i=0; i<3; i++) loc[i] = container.loc(i).data();
+
+  const double* vel[3];
+  for( int i=0; i<3; i++) vel[i] = container.vel(i).data();
+
+  size_t n = 0;
+#if defined(__AVX512F__)
+  n = push_particles<avx512_ops>(loc, vel, c, n, nparts);
+#endif
+#if defined(__AVX2__)
+  n = push_particles<avx2_ops>  (loc, vel, c, n, nparts);
+#endif
+  push_particles<scalar_ops>    (loc, vel, c, n, nparts);
+}
 
-    double u0, v0, w0;
-    double g;
-    double c = 0.5;
 
-    for(int n=n1; n<n2; n++) {
+void Pusher::solve(Tile& tile) 
+{
+  for(auto&& container : tile.containers) solve(container);
+}
 
-      u0 = c*vel[0][n];
-      v0 = c*vel[1][n];
-      w0 = c*vel[2][n];
 
-      // position advance
-      g = c / sqrt(c*c + u0*u0 + v0*v0 + w0*w0);
-      for(size_t i=0; i<3; i++)
-        loc[i][n] += vel[i][n]*g*c;
+const char* Pusher::simd()
+{
+#if defined(__AVX512F__)
+  return "avx512";
+#elif defined(__AVX2__)
+  return "avx2";
+#else
+  return "scalar";
+#endif
+}
 
-    }
-  }//end of loop over species
 
+void Pusher::solve_all(corgi::Grid<2>& grid) 
+{
+  grid.for_each_local_tile([this](corgi::Tile<2>& tile) {
+    solve( dynamic_cast<Tile&>(tile) );
+  });
 }
 
 
@@ -35,36 +35,40 @@ class Tile : public corgi::Tile<2> {
   void set_container(const ParticleBlock& block) {containers.push_back(block);};
 
   size_t Nspecies() {return containers.size(); };
+
+  /// global grid limits used to wrap particles over periodic boundaries
+  std::array<double,3> grid_mins = {{0.0, 0.0, 0.0}};
+  std::array<double,3> grid_maxs = {{1.0, 1.0, 1.0}};
     
 
 
   //--------------------------------------------------
-  // MPI send
+  // MPI messages
+  //
+  // Particles are exchanged in one round through the grid's packed path:
+  // set a codec (e.g., CopyCodec, which sends the packed buffer as is)
+  // for the mode. Messages are sized with MPI_Mprobe, so there is no second
+  // message for large transfers. The per-species particle counts go in the
+  // raw header, so lossy codecs (e.g., FixedRateCodec) only see the doubles.
+
+  /// not used; throws (particle messages have no fixed size)
   std::vector<mpi4cpp::mpi::request> 
   send_data( mpi4cpp::mpi::communicator& /*comm*/, int dest, int mode, int tag) override;
 
-  /// actual tag=0 send
-  std::vector<mpi4cpp::mpi::request> 
-  send_particle_data( mpi4cpp::mpi::communicator& /*comm*/, int dest, int tag);
-
-  /// actual tag=1 send
-  std::vector<mpi4cpp::mpi::request> 
-  send_particle_extra_data( mpi4cpp::mpi::communicator& /*comm*/, int dest, int tag);
-
-
-  //--------------------------------------------------
-  // MPI recv
+  /// not used; throws (particle messages have no fixed size)
   std::vector<mpi4cpp::mpi::request> 
   recv_data(mpi4cpp::mpi::communicator& /*comm*/, int orig, int mode, int tag) override;
 
-  /// actual tag=0 recv
-  std::vector<mpi4cpp::mpi::request> 
-  recv_particle_data(mpi4cpp::mpi::communicator& /*comm*/, int orig, int tag);
+  /// pack the number of particles leaving towards dest of every species (uint64)
+  void pack_header(std::vector<char>& buf, int dest, int mode) override;
 
-  /// actual tag=1 recv
-  std::vector<mpi4cpp::mpi::request> 
-  recv_particle_extra_data(mpi4cpp::mpi::communicator& /*comm*/, int orig, int tag);
-  //--------------------------------------------------
+  /// pack the particles leaving towards the tiles of dest (every species)
+  void pack_data(std::vector<char>& buf, int dest, int mode) override;
+
+  /// append received particles to the containers (of a virtual tile)
+  //
+  // buf holds the pack_header counts followed by the pack_data particles.
+  void unpack_data(const char* buf, size_t size, int orig, int mode) override;
 
 
   /// check all particle containers for particles
@@ -78,11 +82,12 @@ class Tile : public corgi::Tile<2> {
   /// get particles flowing into this tile
   void get_incoming_particles(corgi::Grid<2>& grid);
 
-  /// pack particles for MPI message
-  void pack_outgoing_particles();
-
-  /// unpack received MPI message particles
-  void unpack_incoming_particles();
+  /// get particles flowing into this tile from the neighbor in direction dir;
+  // called via corgi::Grid::pairwise_moore_communication
+  void pairwise_moore_communication(
+      const corgi::Tile<2>& /*other*/,
+      const std::array<int, 2> /*dir_to_other*/,
+      const int /*mode*/) override;
 
   /// delete all particles from each container
   void delete_all_particles();
@@ -92,10 +97,25 @@ class Tile : public corgi::Tile<2> {
 
 
 /// Particle mover
+//
+// The kernel is vectorized with AVX-512 or AVX2 when the compiler targets
+// them (see simd()) and gives the same results as the scalar loop.
+// solve(Tile&) can be used as a StepExecutor compute kernel.
 class Pusher {
 
   public:
+    /// speed of light in grid units
+    double c = 0.5;
+
+    void solve(ParticleBlock& /*container*/);
+
     void solve(Tile& /*tile*/);
+
+    /// push particles of all local tiles (threaded over tiles)
+    void solve_all(corgi::Grid<2>& grid);
+
+    /// instruction set of the kernel: "avx512", "avx2", or "scalar"
+    static const char* simd();
 };
 
 
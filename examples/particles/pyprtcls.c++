@@ -1,5 +1,6 @@
 #include <pybind11/pybind11.h>
 #include <pybind11/stl.h>
+#include <pybind11/numpy.h>
 namespace py = pybind11;
     
 #include "prtcls.h"
@@ -12,26 +13,66 @@ PYBIND11_MODULE(pyprtcls, m) {
     .def(py::init<size_t, size_t, size_t>())
     .def("reserve",       &prtcls::ParticleBlock::reserve)
     .def("size",          &prtcls::ParticleBlock::size)
-    .def("add_particle",  &prtcls::ParticleBlock::add_particle)
+    .def("add_particle",  py::overload_cast<std::vector<double>, std::vector<double>, double>(
+                              &prtcls::ParticleBlock::add_particle))
     .def("add_particle2", [](prtcls::ParticleBlock& s, 
                             double xx, double yy, double zz,
                             double vx, double vy, double vz, 
                             double wgt)
         {
-          s.add_particle({xx,yy,zz}, {vx,vy,vz}, wgt);
+          s.add_particle(xx, yy, zz, vx, vy, vz, wgt);
+        })
+    // bulk append from numpy arrays of equal length
+    .def("add_particles", [](prtcls::ParticleBlock& s,
+                            py::array_t<double, py::array::c_style | py::array::forcecast> x,
+                            py::array_t<double, py::array::c_style | py::array::forcecast> y,
+                            py::array_t<double, py::array::c_style | py::array::forcecast> z,
+                            py::array_t<double, py::array::c_style | py::array::forcecast> ux,
+                            py::array_t<double, py::array::c_style | py::array::forcecast> uy,
+                            py::array_t<double, py::array::c_style | py::array::forcecast> uz,
+                            py::array_t<double, py::array::c_style | py::array::forcecast> wgt)
+        {
+          const size_t n = x.size();
+          for(auto* a : {&y, &z, &ux, &uy, &uz, &wgt}) {
+            if(static_cast<size_t>(a->size()) != n) throw py::value_error("arrays must have equal lengths");
+          }
+          s.add_particles(n, {x.data(), y.data(), z.data(), ux.data(), uy.data(), uz.data(), wgt.data()});
         })
     .def("loc",          [](prtcls::ParticleBlock& s, size_t idim) 
         {
-          return s.loc(idim); 
-        }, py::return_value_policy::reference)
+          auto arr = s.loc(idim);
+          return std::vector<double>(arr.begin(), arr.end()); 
+        })
     .def("vel",          [](prtcls::ParticleBlock& s, size_t idim) 
         {
-          return s.vel(idim); 
-        }, py::return_value_policy::reference)
+          auto arr = s.vel(idim);
+          return std::vector<double>(arr.begin(), arr.end()); 
+        })
     .def("wgt",          [](prtcls::ParticleBlock& s) 
         {
-          return s.wgt(); 
-        }, py::return_value_policy::reference);
+          auto arr = s.wgt();
+          return std::vector<double>(arr.begin(), arr.end()); 
+        })
+    // numpy views to the particle arrays; the container is kept alive by 
+    // the views but they are invalidated by anything that grows it
+    .def("loc_array",    [](py::object self, size_t idim) 
+        {
+          auto& s = self.cast<prtcls::ParticleBlock&>();
+          auto arr = s.loc(idim);
+          return py::array_t<double>(arr.size(), arr.data(), self);
+        })
+    .def("vel_array",    [](py::object self, size_t idim) 
+        {
+          auto& s = self.cast<prtcls::ParticleBlock&>();
+          auto arr = s.vel(idim);
+          return py::array_t<double>(arr.size(), arr.data(), self);
+        })
+    .def("wgt_array",    [](py::object self) 
+        {
+          auto& s = self.cast<prtcls::ParticleBlock&>();
+          auto arr = s.wgt();
+          return py::array_t<double>(arr.size(), arr.data(), self);
+        });
     
 
 
@@ -44,13 +85,13 @@ PYBIND11_MODULE(pyprtcls, m) {
             >(m, "Tile")
     .def(py::init<>())
     .def("get_container",       &prtcls::Tile::get_container, 
-        py::return_value_policy::reference)
+        py::return_value_policy::reference_internal)
     .def("set_container",       &prtcls::Tile::set_container)
+    .def_readwrite("grid_mins",  &prtcls::Tile::grid_mins)
+    .def_readwrite("grid_maxs",  &prtcls::Tile::grid_maxs)
     .def("check_outgoing_particles",     &prtcls::Tile::check_outgoing_particles)
     .def("get_incoming_particles",       &prtcls::Tile::get_incoming_particles)
     .def("delete_transferred_particles", &prtcls::Tile::delete_transferred_particles)
-    .def("pack_outgoing_particles",      &prtcls::Tile::pack_outgoing_particles)
-    .def("unpack_incoming_particles",    &prtcls::Tile::unpack_incoming_particles)
     .def("delete_all_particles",         &prtcls::Tile::delete_all_particles);
 
 
@@ -59,7 +100,12 @@ PYBIND11_MODULE(pyprtcls, m) {
 
   py::class_<prtcls::Pusher>(m, "Pusher")
     .def(py::init<>())
-    .def("solve", &prtcls::Pusher::solve);
+    .def_readwrite("c", &prtcls::Pusher::c)
+    .def("solve", py::overload_cast<prtcls::Tile&>(&prtcls::Pusher::solve))
+    .def("solve", py::overload_cast<prtcls::ParticleBlock&>(&prtcls::Pusher::solve))
+    .def("solve_all", &prtcls::Pusher::solve_all, 
+        py::call_guard<py::gil_scoped_release>())
+    .def_static("simd", &prtcls::Pusher::simd);
 
 
 }
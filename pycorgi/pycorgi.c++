@@ -1,17 +1,65 @@
 #include <pybind11/pybind11.h>
 #include <pybind11/stl.h>
+#include <pybind11/numpy.h>
 namespace py = pybind11;
 
 #include <tuple>
+#include <stdexcept>
 
 #include "corgi/common.h"
 #include "corgi/corgi.h"
+#include "corgi/io/snapshot_writer.h"
+#include "corgi/io/tile_store.h"
+#include "corgi/toolbox/codecs.h"
+#include "corgi/toolbox/instrumentation.h"
 
 
 
 PYBIND11_DECLARE_HOLDER_TYPE(T, std::shared_ptr<T>, true)
 
 
+/// \brief Hand a contiguous vector over to numpy without copying it again
+//
+// The vector is moved into a capsule that is freed together with the array.
+// Grid data is stored first index running fastest, so strides are in 
+// Fortran order and arr[i,j,k] corresponds to the (i,j,k) tile.
+//
+// Same pattern exposes any tile payload: either return an array that 
+// points to the tile memory with the python tile as its base (keeps the 
+// tile alive), or move a temporary buffer into a capsule like here.
+template<typename T, size_t D>
+py::array_t<T> to_ndarray(
+    std::vector<T>&& vec, 
+    const std::array<size_t, D>& lens)
+{
+  auto* data = new std::vector<T>(std::move(vec));
+  py::capsule owner(data, [](void* p) { delete reinterpret_cast<std::vector<T>*>(p); });
+
+  std::vector<py::ssize_t> shape(D), strides(D);
+  py::ssize_t stride = sizeof(T);
+  for(size_t i=0; i<D; i++) {
+    shape[i]   = static_cast<py::ssize_t>(lens[i]);
+    strides[i] = stride;
+    stride    *= static_cast<py::ssize_t>(lens[i]);
+  }
+
+  return py::array_t<T>(shape, strides, data->data(), owner);
+}
+
+/// copy numpy array (any order) into a first-index-fastest vector
+template<typename T, size_t D>
+std::vector<T> from_ndarray(
+    py::array_t<T, py::array::f_style | py::array::forcecast> arr,
+    const std::array<size_t, D>& lens)
+{
+  size_t n = 1;
+  for(size_t i=0; i<D; i++) n *= lens[i];
+  if(static_cast<size_t>(arr.size()) != n) throw std::length_error("array does not match grid size");
+
+  return std::vector<T>(arr.data(), arr.data() + n);
+}
+
+
 template<size_t D>
 auto declare_tile(
     py::module &m, 
@@ -31,6 +79,12 @@ auto declare_tile(
         .def_readwrite("maxs",          &corgi::Tile<D>::maxs)
         .def_readwrite("index",         &corgi::Tile<D>::index)
         .def_readwrite("lengths",       &corgi::Tile<D>::lengths)
+        .def_readonly("measured_work",  &corgi::Tile<D>::measured_work)
+        .def_readwrite("unmeasured_work", &corgi::Tile<D>::unmeasured_work)
+        .def_readonly("halo_directions", &corgi::Tile<D>::halo_directions)
+        .def_readonly("halo_rank",      &corgi::Tile<D>::halo_rank)
+        .def_readwrite("active",        &corgi::Tile<D>::active)
+        .def("get_work",                &corgi::Tile<D>::get_work)
         .def("get_index",               [](
               corgi::Tile<D>& t, corgi::Grid<D>& g)
             {
@@ -75,6 +129,10 @@ auto declare_node(
       std::unique_ptr<corgi::Grid<D>, py::nodelete>
       > corgi_node(m, pyclass_name.c_str());
 
+    // long-running (MPI) methods do not touch python objects; let other 
+    // python threads run while they block
+    const auto release_gil = py::call_guard<py::gil_scoped_release>();
+
     corgi_node
         .def("rank",      [](corgi::Grid<D>& n) { return n.comm.rank(); })
         .def("size",      [](corgi::Grid<D>& n) { return n.comm.size(); })
@@ -85,11 +143,13 @@ auto declare_node(
         .def("get_tile_ids",           &corgi::Grid<D>::get_tile_ids,
                 py::arg("sorted") = true)
         .def("get_tile", 
-            (std::shared_ptr<corgi::Tile<D>> (corgi::Grid<D>::*)(const uint64_t)) 
+            (std::shared_ptr<corgi::Tile<D>> (corgi::Grid<D>::*)(const uint64_t) const) 
               &corgi::Grid<D>::get_tileptr,
               py::return_value_policy::reference,
               py::keep_alive<1,0>()
               )
+        .def("get_tiles",             &corgi::Grid<D>::get_tiles,
+              py::keep_alive<1,0>())
 
         .def("get_local_tiles",             &corgi::Grid<D>::get_local_tiles,
                  py::arg("sorted") = true)
@@ -97,32 +157,135 @@ auto declare_node(
                  py::arg("sorted") = true)
         .def("get_boundary_tiles",          &corgi::Grid<D>::get_boundary_tiles,
                  py::arg("sorted") = true)
+        .def("get_interior_tiles",          &corgi::Grid<D>::get_interior_tiles,
+                 py::arg("sorted") = true)
+        .def("get_active_tiles",            &corgi::Grid<D>::get_active_tiles,
+                 py::arg("sorted") = true)
+
+        // intra-rank threading
+        .def("set_num_threads",       &corgi::Grid<D>::set_num_threads)
+        .def("get_num_threads",       &corgi::Grid<D>::get_num_threads)
+        .def("set_work_timing",       &corgi::Grid<D>::set_work_timing)
+
+        // whole ownership/work grids as numpy arrays; one C++ copy and no
+        // per-element python objects
+        .def("get_mpi_grid_array",    [](corgi::Grid<D>& g) {
+              return to_ndarray<int, D>( g.py_get_mpi_grid_data(), g.lens() );
+            })
+        .def("set_mpi_grid_array",    [](corgi::Grid<D>& g, 
+              py::array_t<int, py::array::f_style | py::array::forcecast> arr) {
+              auto vec = from_ndarray<int, D>(arr, g.lens());
+              g.py_set_mpi_grid_data(vec);
+            })
+        .def("get_work_grid_array",   [](corgi::Grid<D>& g) {
+              return to_ndarray<double, D>( g.py_get_work_grid_data(), g.lens() );
+            })
+        .def("set_work_grid_array",   [](corgi::Grid<D>& g, 
+              py::array_t<double, py::array::f_style | py::array::forcecast> arr) {
+              auto vec = from_ndarray<double, D>(arr, g.lens());
+              g.py_set_work_grid_data(vec);
+            })
 
         .def("is_local",              &corgi::Grid<D>::is_local)
-        .def("analyze_boundaries", &corgi::Grid<D>::analyze_boundaries)
+        .def("analyze_boundaries", &corgi::Grid<D>::analyze_boundaries,
+                release_gil)
 
         // // communication wrappers
-        .def("send_tile",               &corgi::Grid<D>::send_tile)
-        .def("recv_tile",               &corgi::Grid<D>::recv_tile)
+        .def("send_tile",               &corgi::Grid<D>::send_tile,
+                release_gil)
+        .def("recv_tile",               &corgi::Grid<D>::recv_tile,
+                release_gil)
         .def_readwrite("send_queue",         &corgi::Grid<D>::send_queue)
         .def_readwrite("send_queue_address", &corgi::Grid<D>::send_queue_address)
-        .def("bcast_mpi_grid",          &corgi::Grid<D>::bcast_mpi_grid)
-        .def("allgather_work_grid",     &corgi::Grid<D>::allgather_work_grid)
-        .def("update_work",             &corgi::Grid<D>::update_work)
-
-        .def("send_tiles",              &corgi::Grid<D>::send_tiles)
-        .def("recv_tiles",              &corgi::Grid<D>::recv_tiles)
-        .def("send_data",               &corgi::Grid<D>::send_data)
-        .def("recv_data",               &corgi::Grid<D>::recv_data)
-        .def("wait_data",               &corgi::Grid<D>::wait_data)
+        .def("bcast_mpi_grid",          &corgi::Grid<D>::bcast_mpi_grid,
+                release_gil)
+        .def("allgather_work_grid",     &corgi::Grid<D>::allgather_work_grid,
+                release_gil)
+        .def("update_work",             &corgi::Grid<D>::update_work,
+                release_gil)
+
+        .def("send_tiles",              &corgi::Grid<D>::send_tiles,
+                release_gil)
+        .def("recv_tiles",              &corgi::Grid<D>::recv_tiles,
+                release_gil)
+        .def("send_data",               &corgi::Grid<D>::send_data,
+                release_gil)
+        .def("recv_data",               &corgi::Grid<D>::recv_data,
+                release_gil)
+        .def("wait_data",               &corgi::Grid<D>::wait_data,
+                release_gil)
+        .def("exchange_data",           &corgi::Grid<D>::exchange_data,
+                release_gil)
+        .def("exchange_activity",       &corgi::Grid<D>::exchange_activity,
+                py::arg("mode"),
+                release_gil)
 
         // adoption routines
-        .def("adopt",                   &corgi::Grid<D>::adopt)
-        .def("adoption_council",        &corgi::Grid<D>::adoption_council)
-        .def("adoption_council2",       &corgi::Grid<D>::adoption_council2)
-        .def("communicate_adoptions",   &corgi::Grid<D>::communicate_adoptions)
-        .def("erase_virtuals",          &corgi::Grid<D>::erase_virtuals)
-        .def("pairwise_moore_communication", &corgi::Grid<D>::pairwise_moore_communication);
+        .def("adopt",                   &corgi::Grid<D>::adopt,
+                release_gil)
+        .def("adoption_council",        &corgi::Grid<D>::adoption_council,
+                release_gil)
+        .def("adoption_council2",       &corgi::Grid<D>::adoption_council2,
+                release_gil)
+        .def("communicate_adoptions",   &corgi::Grid<D>::communicate_adoptions,
+                release_gil)
+        .def("erase_virtuals",          &corgi::Grid<D>::erase_virtuals,
+                release_gil)
+
+        // checkpoints
+        .def("write_checkpoint",        &corgi::Grid<D>::write_checkpoint,
+                py::arg("fname"), py::arg("step") = 0, 
+                release_gil)
+        .def("read_checkpoint",         [](py::object self, const std::string& fname, py::object factory) 
+            {
+              auto& g = self.cast<corgi::Grid<D>&>();
+              if(factory.is_none()) return g.read_checkpoint(fname);
+
+              // tiles made in python are kept alive by the grid (as in add_tile)
+              return g.read_checkpoint(fname, [&self, &factory]() {
+                  py::object tile = factory();
+                  py::detail::keep_alive_impl(self, tile);
+                  return tile.cast<std::shared_ptr<corgi::Tile<D>>>();
+                  });
+            }, py::arg("fname"), py::arg("factory") = py::none())
+        // message compression
+        .def("set_codec",         &corgi::Grid<D>::set_codec)
+        .def("get_codec",         &corgi::Grid<D>::get_codec)
+        .def("get_codec_stats",   &corgi::Grid<D>::get_codec_stats)
+        .def("reset_codec_stats", &corgi::Grid<D>::reset_codec_stats)
+        // phase timers and message counters; {phase name: stats}
+        .def("get_phase_stats", [](const corgi::Grid<D>& g) {
+            using corgi::tools::phase;
+            py::dict ret;
+            for(size_t p=0; p<corgi::tools::phase_timers::num_phases; p++) {
+              ret[corgi::tools::phase_name(static_cast<phase>(p))] = g.get_phase_stats().get(static_cast<phase>(p));
+            }
+            return ret;
+            })
+        .def("reduce_phase_stats", [](const corgi::Grid<D>& g) {
+            std::vector<corgi::tools::phase_summary> sums;
+            {
+              py::gil_scoped_release release;
+              sums = g.reduce_phase_stats();
+            }
+            py::dict ret;
+            for(auto& s : sums) ret[py::str(s.name)] = s;
+            return ret;
+            })
+        .def("get_bytes_sent_to", [](const corgi::Grid<D>& g) { return g.get_phase_stats().bytes_to(); })
+        .def("reset_phase_stats", &corgi::Grid<D>::reset_phase_stats)
+        // event timeline (Chrome trace JSON)
+        .def("start_trace",       &corgi::Grid<D>::start_trace, py::arg("capacity") = 65536)
+        .def("stop_trace",        &corgi::Grid<D>::stop_trace)
+        .def("write_trace",       &corgi::Grid<D>::write_trace, py::arg("fname"),
+                release_gil)
+        // partition quality
+        .def("make_comm_report",  &corgi::Grid<D>::make_comm_report, py::arg("mode") = 0,
+                release_gil)
+        .def("write_comm_report", &corgi::Grid<D>::write_comm_report, py::arg("prefix"), py::arg("mode") = 0,
+                release_gil)
+        .def("pairwise_moore_communication", &corgi::Grid<D>::pairwise_moore_communication,
+                release_gil);
 
   return corgi_node;
 }
@@ -130,6 +293,53 @@ auto declare_node(
 
 
 
+/// read-only numpy view into a mapped TileStore; the store is kept alive as the base
+py::array store_view(
+    py::object store,
+    py::dtype dt,
+    const std::vector<py::ssize_t>& shape,
+    const void* ptr)
+{
+  // first index running fastest like the grid arrays
+  std::vector<py::ssize_t> strides(shape.size());
+  py::ssize_t stride = dt.itemsize();
+  for(size_t i=0; i<shape.size(); i++) {
+    strides[i] = stride;
+    stride    *= shape[i];
+  }
+
+  py::array arr(dt, shape, strides, ptr, store);
+  arr.attr("setflags")(false); // mapping is PROT_READ
+  return arr;
+}
+
+
+
+template<size_t D>
+auto declare_snapshot_writer(
+    py::module &m, 
+    const std::string& pyclass_name) 
+{
+  using Writer = corgi::io::SnapshotWriter<D>;
+  const auto release_gil = py::call_guard<py::gil_scoped_release>();
+
+  return py::class_<Writer>(m, pyclass_name.c_str())
+    .def(py::init<corgi::Grid<D>&, std::string, size_t>(),
+        py::arg("grid"), py::arg("prefix"), py::arg("memory_budget") = 256*1024*1024,
+        py::keep_alive<1,2>())
+    .def("snapshot", py::overload_cast<int64_t>(&Writer::snapshot),
+        py::arg("step"), release_gil)
+    .def("snapshot", py::overload_cast<int64_t, const std::vector<uint64_t>&>(&Writer::snapshot),
+        py::arg("step"), py::arg("cids"), release_gil)
+    .def("flush",         &Writer::flush, release_gil)
+    .def("bytes_written", &Writer::bytes_written)
+    .def("staged_bytes",  &Writer::staged_bytes)
+    .def("held_bytes",    &Writer::held_bytes)
+    .def_readonly("stall_time", &Writer::stall_time);
+}
+
+
+
 // --------------------------------------------------
 PYBIND11_MODULE(pycorgi, m_base) {
 
@@ -150,6 +360,166 @@ PYBIND11_MODULE(pycorgi, m_base) {
         //.def_readwrite("virtual_owners",              &corgi::Communication::virtual_owners                      )
       
 
+    //--------------------------------------------------
+    // message codecs (see Grid.set_codec)
+    using corgi::tools::codec;
+
+    py::class_<codec, std::shared_ptr<codec>>(m_base, "Codec")
+        .def("lossless", &codec::lossless)
+        .def("identity", &codec::identity)
+        // any contiguous array (or bytes) in, bytes out
+        .def("encode", [](const codec& c, py::object obj) {
+            auto arr = py::array::ensure(obj, py::array::c_style);
+            if(!arr) throw std::invalid_argument("encode needs an array-like object");
+            std::vector<char> out;
+            c.encode(static_cast<const char*>(arr.data()), arr.nbytes(), out);
+            return py::bytes(out.data(), out.size());
+            })
+        .def("decode", [](const codec& c, const py::bytes& msg) {
+            const std::string in = msg;
+            std::vector<char> out;
+            c.decode(in.data(), in.size(), out);
+            return py::bytes(out.data(), out.size());
+            });
+
+    py::class_<corgi::tools::copy_codec, codec, 
+      std::shared_ptr<corgi::tools::copy_codec>>(m_base, "CopyCodec")
+        .def(py::init<>());
+
+    py::class_<corgi::tools::bitpack_codec<int32_t>, codec, 
+      std::shared_ptr<corgi::tools::bitpack_codec<int32_t>>>(m_base, "BitpackCodec")
+        .def(py::init<>());
+
+    py::class_<corgi::tools::delta_varint_codec<int64_t>, codec, 
+      std::shared_ptr<corgi::tools::delta_varint_codec<int64_t>>>(m_base, "DeltaVarintCodec")
+        .def(py::init<>());
+
+    py::class_<corgi::tools::fixed_rate_codec<double>, codec, 
+      std::shared_ptr<corgi::tools::fixed_rate_codec<double>>>(m_base, "FixedRateCodec")
+        .def(py::init<int>(), py::arg("bits") = 16);
+
+    py::class_<corgi::tools::codec_stats>(m_base, "CodecStats")
+        .def_readonly("sent_messages",      &corgi::tools::codec_stats::sent_messages)
+        .def_readonly("recv_messages",      &corgi::tools::codec_stats::recv_messages)
+        .def_readonly("raw_bytes_sent",     &corgi::tools::codec_stats::raw_bytes_sent)
+        .def_readonly("encoded_bytes_sent", &corgi::tools::codec_stats::encoded_bytes_sent)
+        .def_readonly("raw_bytes_recv",     &corgi::tools::codec_stats::raw_bytes_recv)
+        .def_readonly("encoded_bytes_recv", &corgi::tools::codec_stats::encoded_bytes_recv)
+        .def_readonly("encode_time",        &corgi::tools::codec_stats::encode_time)
+        .def_readonly("decode_time",        &corgi::tools::codec_stats::decode_time)
+        .def("ratio",                       &corgi::tools::codec_stats::ratio);
+
+
+    //--------------------------------------------------
+    // grid instrumentation (see Grid.get_phase_stats)
+    m_base.attr("instrumentation") = corgi::tools::phase_timers::enabled;
+
+    py::class_<corgi::tools::phase_counters>(m_base, "PhaseCounters")
+        .def_readonly("calls",    &corgi::tools::phase_counters::calls)
+        .def_readonly("time",     &corgi::tools::phase_counters::time)
+        .def_readonly("messages", &corgi::tools::phase_counters::messages)
+        .def_readonly("bytes",    &corgi::tools::phase_counters::bytes)
+        .def_readonly("tiles",    &corgi::tools::phase_counters::tiles);
+
+    py::class_<corgi::tools::rank_summary>(m_base, "RankSummary")
+        .def_readonly("min",  &corgi::tools::rank_summary::min)
+        .def_readonly("max",  &corgi::tools::rank_summary::max)
+        .def_readonly("mean", &corgi::tools::rank_summary::mean)
+        .def("imbalance",     &corgi::tools::rank_summary::imbalance);
+
+    py::class_<corgi::tools::phase_summary>(m_base, "PhaseSummary")
+        .def_readonly("name",     &corgi::tools::phase_summary::name)
+        .def_readonly("calls",    &corgi::tools::phase_summary::calls)
+        .def_readonly("time",     &corgi::tools::phase_summary::time)
+        .def_readonly("messages", &corgi::tools::phase_summary::messages)
+        .def_readonly("bytes",    &corgi::tools::phase_summary::bytes)
+        .def_readonly("tiles",    &corgi::tools::phase_summary::tiles);
+
+
+    // rank x rank matrices are copied into (sender, receiver) arrays
+    using corgi::io::comm_report;
+    auto rank_matrix = [](const comm_report& r, const std::vector<uint64_t>& m) {
+      return py::array_t<uint64_t>({ r.ranks, r.ranks }, m.data());
+    };
+
+    py::class_<comm_report>(m_base, "CommReport")
+        .def_readonly("ranks",          &comm_report::ranks)
+        .def_readonly("mode",           &comm_report::mode)
+        .def_readonly("local_tiles",    &comm_report::local_tiles)
+        .def_readonly("boundary_tiles", &comm_report::boundary_tiles)
+        .def_readonly("virtual_tiles",  &comm_report::virtual_tiles)
+        .def_property_readonly("messages", [rank_matrix](const comm_report& r) { return rank_matrix(r, r.messages); })
+        .def_property_readonly("bytes",    [rank_matrix](const comm_report& r) { return rank_matrix(r, r.bytes); })
+        .def("bytes_sent",        &comm_report::bytes_sent)
+        .def("bytes_recv",        &comm_report::bytes_recv)
+        .def("neighbors",         &comm_report::neighbors)
+        .def("surface_to_volume", &comm_report::surface_to_volume)
+        .def("halo_to_volume",    &comm_report::halo_to_volume)
+        .def("total_messages",    &comm_report::total_messages)
+        .def("total_bytes",       &comm_report::total_bytes)
+        .def("max_rank_bytes",    &comm_report::max_rank_bytes)
+        .def("write_csv",         &comm_report::write_csv, py::arg("prefix"));
+
+
+    //--------------------------------------------------
+    // post-processing of checkpoint files (no MPI needed)
+    using corgi::io::TileStore;
+
+    auto grid_shape = [](const TileStore& s) {
+      std::vector<py::ssize_t> shape;
+      for(size_t i=0; i<s.dims(); i++) shape.push_back( s.lengths()[i] );
+      return shape;
+    };
+
+    py::class_<TileStore>(m_base, "TileStore")
+        .def(py::init<std::string>(), py::arg("fname"))
+        .def("dims",        &TileStore::dims)
+        .def("step",        &TileStore::step)
+        .def("num_cells",   &TileStore::num_cells)
+        .def("num_tiles",   &TileStore::num_tiles)
+        .def("has_tile",    &TileStore::has_tile)
+        .def("get_tile_ids",&TileStore::get_tile_ids)
+        .def("id", [](const TileStore& s, py::args ind) {
+            std::array<size_t, 3> ijk = {{0,0,0}};
+            if(ind.size() != s.dims()) throw std::length_error("wrong number of indices");
+            for(size_t i=0; i<ind.size(); i++) ijk[i] = ind[i].cast<size_t>();
+            return s.id(ijk[0], ijk[1], ijk[2]);
+            })
+        .def("get_lengths", [grid_shape](const TileStore& s) { return grid_shape(s); })
+        .def("get_mins", [](const TileStore& s) {
+            auto m = s.mins(); return std::vector<double>(m.begin(), m.begin() + s.dims()); })
+        .def("get_maxs", [](const TileStore& s) {
+            auto m = s.maxs(); return std::vector<double>(m.begin(), m.begin() + s.dims()); })
+        .def("get_mpi_grid", [grid_shape](py::object self) {
+            const auto& s = self.cast<const TileStore&>();
+            return store_view(self, py::dtype::of<int32_t>(), grid_shape(s), s.mpi_grid());
+            })
+        .def("get_work_grid", [grid_shape](py::object self) {
+            const auto& s = self.cast<const TileStore&>();
+            return store_view(self, py::dtype::of<double>(), grid_shape(s), s.work_grid());
+            })
+        .def("get_tile_info", [](const TileStore& s, uint64_t cid) {
+            const auto& r = s.record(cid);
+            const size_t d = s.dims();
+            py::dict info;
+            info["cid"]   = r.cid;
+            info["owner"] = r.owner;
+            info["index"] = py::tuple( py::cast(std::vector<int32_t>(r.indices, r.indices + d)) );
+            info["mins"]  = std::vector<double>(r.mins, r.mins + d);
+            info["maxs"]  = std::vector<double>(r.maxs, r.maxs + d);
+            info["work"]  = r.work;
+            return info;
+            })
+        // payload as a flat array of dtype; nothing is read before it is accessed
+        .def("get_tile", [](py::object self, uint64_t cid, py::object dtype) {
+            const auto& s = self.cast<const TileStore&>();
+            auto v  = s.get_tile(cid);
+            auto dt = py::dtype::from_args(dtype);
+            if(v.size % dt.itemsize() != 0) throw std::length_error("payload size is not a multiple of dtype size");
+            return store_view(self, dt, { static_cast<py::ssize_t>(v.size/dt.itemsize()) }, v.data);
+            }, py::arg("cid"), py::arg("dtype") = py::str("u1"));
+
+
     //--------------------------------------------------
     // 1D
       
@@ -243,6 +613,8 @@ PYBIND11_MODULE(pycorgi, m_base) {
     auto t1 = declare_tile<1>(m_1d, "Tile");
     t1.def("neighs", [](corgi::Tile<1> &t, int i ){ return t.neighs(i); });
 
+    declare_snapshot_writer<1>(m_1d, "SnapshotWriter");
+
 
 
     //--------------------------------------------------
@@ -310,6 +682,8 @@ PYBIND11_MODULE(pycorgi, m_base) {
     auto t2 = declare_tile<2>(m_2d, "Tile");
     t2.def("neighs", [](corgi::Tile<2> &t, int i, int j){ return t.neighs(i,j); });
 
+    declare_snapshot_writer<2>(m_2d, "SnapshotWriter");
+
 
     //--------------------------------------------------
     // 3D
@@ -372,6 +746,8 @@ PYBIND11_MODULE(pycorgi, m_base) {
     auto t3 = declare_tile<3>(m_3d, "Tile");
     t3.def("neighs", [](corgi::Tile<3> &t, int i, int j, int k){ return t.neighs(i,j,k); });
 
+    declare_snapshot_writer<3>(m_3d, "SnapshotWriter");
+
 
 }
 
@@ -111,6 +111,8 @@ namespace commType {
         NTILES,   //! Number of incoming tiles,
         TILEDATA, //! Tile data array
         ADOPT,
+        ACTIVITY, //! Activity flags of boundary tiles
+        TRACE,    //! Trace events gathered by write_trace
         N_COMMTYPES
     };
 }
@@ -15,9 +15,27 @@
 #include <initializer_list>
 #include <sstream>
 #include <utility>
+#include <tuple>
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <functional>
+#include <cstdint>
+#include <climits>
+#include <cstring>
+#include <stdexcept>
+#include <exception>
+#include <fstream>
+#include <limits>
+#include <cstdio>
 
 #include "corgi/internals.h"
 #include "corgi/toolbox/sparse_grid.h"
+#include "corgi/toolbox/thread_pool.h"
+#include "corgi/toolbox/codecs.h"
+#include "corgi/toolbox/instrumentation.h"
+#include "corgi/io/checkpoint_format.h"
+#include "corgi/io/comm_report.h"
 #include "corgi/tile.h"
 
 //#include "mpi.h"
@@ -27,6 +45,9 @@
 
 namespace corgi {
 
+template<std::size_t D>
+class StepExecutor;
+
 
 /*! Individual grid object that stores patches of grid in it.
  *
@@ -39,6 +60,7 @@ template<std::size_t D>
 class Grid
 {
 
+  friend class StepExecutor<D>;
 
   public:
       
@@ -84,9 +106,27 @@ class Grid
   public:
 
   /// Map with tile_id & tile data
+  //
+  // NOTE: the map is only read (never modified) inside the for_each_*
+  // loops so that worker threads can look up neighbors concurrently.
   Tile_map tiles;
 
 
+  private:
+
+  /// intra-rank worker threads; created lazily
+  std::unique_ptr<corgi::tools::thread_pool> _pool;
+
+  /// set while worker threads are running over the tiles
+  std::atomic<bool> _in_parallel_region{false};
+
+  /// record execution time of tiles in the for_each_* loops
+  bool _work_timing = false;
+
+  /// timers and message counters of the public phases
+  corgi::tools::phase_timers _timers;
+
+
   public:
   // --------------------------------------------------
   // Python bindings for mpi_grid
@@ -127,6 +167,19 @@ class Grid
     _work_grid(indices...) = val;
   }
 
+  // whole grids as contiguous arrays (first index running fastest)
+  std::vector<int> py_get_mpi_grid_data() { return _mpi_grid.serialize(); }
+
+  void py_set_mpi_grid_data(std::vector<int>& vec) { 
+    _mpi_grid.deserialize(vec, _lengths); 
+  }
+
+  std::vector<double> py_get_work_grid_data() { return _work_grid.serialize(); }
+
+  void py_set_work_grid_data(std::vector<double>& vec) { 
+    _work_grid.deserialize(vec, _lengths); 
+  }
+
 
   public:
 
@@ -482,6 +535,7 @@ class Grid
   {
     // check that we are not appending nullptr
     assert(tileptr);
+    assert(!_in_parallel_region); // tile map must not change under worker threads
 
     // claim unique ownership of the tile (for unique_ptr)
     // std::unique_ptr<corgi::Tile> tileptr = std::make_unique<corgi:Tile>(tile);
@@ -523,6 +577,7 @@ class Grid
   {
     // check that we are not appending nullptr
     assert(tileptr);
+    assert(!_in_parallel_region); // tile map must not change under worker threads
 
     // calculate unique global tile ID
     uint64_t cid = id(indices);
@@ -530,9 +585,10 @@ class Grid
     // add tile if it does not exist
     if(tiles.count(cid) == 0) return add_tile(tileptr, indices);
 
-    // else replace previous one; copy Communication object
+    // else replace previous one; copy Communication object and activity
     auto& tile = get_tile(cid);
     auto cm = tile.communication;
+    tileptr->active = tile.active;
 
     tileptr->index   = indices;
     tileptr->cid     = cid;
@@ -550,6 +606,8 @@ class Grid
   // FIXME
   void create_tile(Communication& cm)
   {
+    assert(!_in_parallel_region); // tile map must not change under worker threads
+
     //m_author = std::make_shared<Author>(t_author);
     auto tileptr = std::make_shared<Tile_t>();
     tileptr->load_metainfo(cm);
@@ -610,6 +668,13 @@ class Grid
     return *(it->second);
   }
 
+  const Tile_t& get_tile(const uint64_t cid) const {
+    auto it = tiles.find(cid);
+    if (it == tiles.end()) { throw std::invalid_argument("tile entry not found"); }
+
+    return *(it->second);
+  }
+
   template<typename... Indices>
     corgi::internals::enable_if_t< (sizeof...(Indices) == D) && 
     corgi::internals::are_integral<Indices...>::value, 
@@ -620,34 +685,42 @@ class Grid
   }
 
   /// \brief Get individual tile (as a pointer)
-  Tileptr get_tileptr(const uint64_t cid) {
+  Tileptr get_tileptr(const uint64_t cid) const {
     auto it = tiles.find(cid);
     if (it == tiles.end()) { return nullptr; };
     return it->second;
   }
 
+  /// Get many tiles (as pointers) in one call; missing tiles are nullptr
+  std::vector<Tileptr> get_tiles(const std::vector<uint64_t>& cids) const {
+    std::vector<Tileptr> ret;
+    ret.reserve(cids.size());
+    for(auto cid : cids) ret.push_back( get_tileptr(cid) );
+    return ret;
+  }
+
   template<typename... Indices>
     corgi::internals::enable_if_t< (sizeof...(Indices) == D) && 
     corgi::internals::are_integral<Indices...>::value, 
   Tileptr>
-  get_tileptr_ind(const Indices... indices)
+  get_tileptr_ind(const Indices... indices) const
   {
     uint64_t cid = id(indices...);
     return get_tileptr(cid);
   }
 
-  Tileptr get_tileptr(const std::tuple<size_t> ind) {
+  Tileptr get_tileptr(const std::tuple<size_t> ind) const {
     size_t i = std::get<0>(ind);
     return get_tileptr_ind(i);
   }
 
-  Tileptr get_tileptr(const std::tuple<size_t, size_t> ind) {
+  Tileptr get_tileptr(const std::tuple<size_t, size_t> ind) const {
     size_t i = std::get<0>(ind);
     size_t j = std::get<1>(ind);
     return get_tileptr_ind(i, j);
   }
 
-  Tileptr get_tileptr(const std::tuple<size_t, size_t, size_t> ind) {
+  Tileptr get_tileptr(const std::tuple<size_t, size_t, size_t> ind) const {
     size_t i = std::get<0>(ind);
     size_t j = std::get<1>(ind);
     size_t k = std::get<2>(ind);
@@ -714,6 +787,23 @@ class Grid
     return tile_list;
   }
 
+  /// Return all local tiles that have no virtual neighbors
+  std::vector<uint64_t> get_interior_tiles(
+      const bool sorted=false ) {
+
+    std::vector<uint64_t> tile_list = get_tile_ids(sorted);
+    std::vector<uint64_t> ret;
+    ret.reserve(tile_list.size());
+
+    for(auto elem : tile_list) {
+      auto& c = tiles.at( elem )->communication;
+      if(c.owner == comm.rank() && c.number_of_virtual_neighbors == 0) {
+        ret.push_back(elem);
+      }
+    }
+    return ret;
+  }
+
 
   // /// Check if we have a tile with the given index
   bool is_local(uint64_t cid) {
@@ -760,6 +850,17 @@ class Grid
   }
 
 
+  /// group the Moore directions of a tile by the owners of the neighbors
+  void set_halo_directions(Tile_t& tile)
+  {
+    tile.halo_directions.clear();
+    tile.halo_rank = comm.rank();
+    for(auto& rel: corgi::ca::moore_neighborhood<D>()) {
+      tile.halo_directions[ _mpi_grid(tile.neighs(rel)) ].push_back(rel);
+    }
+  }
+
+
   /// map of owners to exterior (=virtual) tiles
   std::map<int, std::set<uint64_t> > virtual_tile_list;
 
@@ -779,20 +880,32 @@ class Grid
   //  * `rank_virtuals` function.
   //  * */
   void analyze_boundaries() {
+    using corgi::tools::phase;
+    auto timer = _timers.time(phase::analyze_boundaries);
 
     virtual_tile_list.clear();
     boundary_tile_list.clear();
     send_queue.clear();
     send_queue_address.clear();
 
+    // new topology; everything is computed and sent at least once
+    _quiet_sends.clear();
+    _quiet_recvs.clear();
+    for(auto& elem : tiles) elem.second->active = true;
+
     // analyze all of my local tiles
-    for(auto cid: get_local_tiles()) {
+    const auto local_ids = get_local_tiles();
+    _timers.tiles(phase::analyze_boundaries, local_ids.size());
+    for(auto cid: local_ids) {
       auto& c = get_tile(cid);
+      c.halo_directions.clear();
+      c.halo_rank = comm.rank();
 
       // analyze c's neighborhood
-      auto neigs = c.nhood();
-      for(auto& indx: neigs) {
+      for(auto& rel: corgi::ca::moore_neighborhood<D>()) {
+        auto indx = c.neighs(rel);
         int whoami = _mpi_grid(indx); // Get tile id from index notation
+        c.halo_directions[whoami].push_back(rel);
 
         // if nbor tile is virtual
         if(whoami != comm.rank()) {
@@ -934,6 +1047,18 @@ class Grid
   std::vector<mpi::request> recv_tile_messages;
   std::unordered_map<int, std::vector<mpi::request>> recv_data_messages;
 
+  /// (cid, first, last) slices of recv_data_messages belonging to each virtual tile
+  std::unordered_map<int, std::vector<std::tuple<uint64_t, size_t, size_t>>> recv_data_ranges;
+
+  /// encoded outgoing messages of codec modes; kept alive until wait_data
+  std::unordered_map<int, std::vector<std::vector<char>>> sent_data_buffers;
+
+  /// (orig, tag) of each recv_data_ranges entry of codec modes
+  std::unordered_map<int, std::vector<std::pair<int,int>>> recv_data_sources;
+
+  /// recv_data_ranges entries of codec modes that are received and unpacked
+  std::unordered_map<int, std::vector<char>> recv_data_done;
+
   std::vector<mpi::request> sent_adoption_messages;
   std::vector<mpi::request> recv_adoption_messages;
 
@@ -1017,12 +1142,32 @@ class Grid
   }
 
 
-  // Update work load grid from my local tiles
+  // Update work load grid from my local tiles (collective)
+  //
+  // Timings collected by the threaded loops are committed here first.
+  // Tiles that have not been measured yet are given the mean measured
+  // work over all ranks so that the grid does not mix seconds with the
+  // unit default; until some tile has been measured all keep 1.0.
   void update_work()
   {
-    for(auto& cid : get_local_tiles()) {
+    const auto local = get_local_tiles();
+
+    // sum and count of measured tiles
+    double sums[2] = {0.0, 0.0};
+    for(auto& cid : local) {
+      auto& tile = get_tile(cid);
+      tile.commit_work();
+      if(tile.measured_work > 0.0) {
+        sums[0] += tile.measured_work;
+        sums[1] += 1.0;
+      }
+    }
+    MPI_Allreduce(MPI_IN_PLACE, sums, 2, MPI_DOUBLE, MPI_SUM, MPI_COMM_WORLD);
+
+    for(auto& cid : local) {
       auto& tile = get_tile(cid);
-     _work_grid( tile.index ) = tile.get_work();
+      if(sums[1] > 0.0) tile.unmeasured_work = sums[0]/sums[1];
+      _work_grid( tile.index ) = tile.get_work();
     }
   }
 
@@ -1032,6 +1177,9 @@ class Grid
   // First we send a warning message of how many tiles to expect.
   // Based on this the receiving side can prepare accordingly.
   void send_tiles() {
+    using corgi::tools::phase;
+    auto timer = _timers.time(phase::send_tiles);
+    _timers.tiles(phase::send_tiles, boundary_tile_list.size());
 
     sent_info_messages.clear();
     sent_tile_messages.clear();
@@ -1046,6 +1194,7 @@ class Grid
 
         mpi::request req;
         req = comm.isend(dest, commType::TILEDATA, tile.communication);
+        _timers.sent(phase::send_tiles, dest, 1, sizeof(Communication));
 
         sent_tile_messages.push_back( req );
       }
@@ -1096,6 +1245,9 @@ class Grid
   /// Receive incoming stuff
   std::vector<Communication> rcoms;
   void recv_tiles() {
+    using corgi::tools::phase;
+    auto timer = _timers.time(phase::recv_tiles);
+
     recv_tile_messages.clear();
     rcoms.clear();
 
@@ -1103,6 +1255,9 @@ class Grid
     for(auto&& elem : virtual_tile_list) nelems += elem.second.size();
     rcoms.resize( nelems );
 
+    _timers.tiles(phase::recv_tiles, nelems);
+    _timers.count(phase::recv_tiles, nelems, nelems*sizeof(Communication));
+
     int i = 0;
     for(auto&& elem : virtual_tile_list) {
       int orig = elem.first;
@@ -1209,6 +1364,9 @@ class Grid
   /// Propagate CA rules one step forward and decide who adopts who
   void adoption_council()
   {
+    using corgi::tools::phase;
+    auto timer = _timers.time(phase::adoption_council);
+
     int quota = (int)get_quota(comm.rank());
 
     // collect virtual tiles and their metainfo into a container
@@ -1244,6 +1402,7 @@ class Grid
       if( (int)adoptions.size() >= quota) break;
     }
 
+    _timers.tiles(phase::adoption_council, adoptions.size());
   }
 
   /// general N-dim implementation of wrap
@@ -1293,6 +1452,9 @@ class Grid
 
   void adoption_council2()
   {
+    using corgi::tools::phase;
+    auto timer = _timers.time(phase::adoption_council);
+
     adoptions.clear();
     kidnaps.clear();
     std::vector<double> alives(comm.size());
@@ -1480,6 +1642,8 @@ class Grid
 
     // global progress
     _mpi_grid = std::move(new_mpi_grid);
+
+    _timers.tiles(phase::adoption_council, adoptions.size() + kidnaps.size());
  }
 
 
@@ -1506,6 +1670,9 @@ class Grid
   /// send MPI message of my adoptions to everybody
   void send_adoptions()
   {
+    using corgi::tools::phase;
+    auto timer = _timers.time(phase::communicate_adoptions);
+
     sent_adoption_messages.clear();
 
     // ensure that adoptions vector is of standard length
@@ -1518,12 +1685,16 @@ class Grid
       mpi::request req;
       req = comm.isend(dest, commType::ADOPT, adoptions.data(), max_quota);
       sent_adoption_messages.push_back( req );
+      _timers.sent(phase::communicate_adoptions, dest, 1, static_cast<int>(max_quota)*sizeof(int));
     }
   }
 
   /// receive MPI adoption messages from others
   void recv_adoptions()
   {
+    using corgi::tools::phase;
+    auto timer = _timers.time(phase::communicate_adoptions);
+
     recv_adoption_messages.clear();
 
     // ensure that the receiving array is of correct size
@@ -1535,6 +1706,7 @@ class Grid
       mpi::request req;
       req = comm.irecv(orig, commType::ADOPT, &kidnaps[orig*max_quota], max_quota);
       recv_adoption_messages.push_back( req );
+      _timers.count(phase::communicate_adoptions, 1, static_cast<int>(max_quota)*sizeof(int));
     }
 
   }
@@ -1545,6 +1717,8 @@ class Grid
   // even if they are remote and do not consider me.
   void wait_adoptions()
   {
+    auto timer = _timers.time(corgi::tools::phase::communicate_adoptions);
+
     // wait
     mpi::wait_all(recv_adoption_messages.begin(), recv_adoption_messages.end());
     mpi::wait_all(sent_adoption_messages.begin(), sent_adoption_messages.end());
@@ -1602,11 +1776,263 @@ class Grid
         if(whoami == comm.rank()) continue;
       }
 
+      assert(!_in_parallel_region);
       tiles.erase(cid);
     }
   }
 
 
+  // --------------------------------------------------
+  // intra-rank (threaded) tile loops
+
+  /// set number of worker threads used by the for_each_* loops
+  void set_num_threads(size_t n)
+  {
+    assert(!_in_parallel_region);
+    _pool = std::make_unique<corgi::tools::thread_pool>(n);
+  }
+
+  /// number of worker threads (including the calling thread)
+  size_t get_num_threads() 
+  {
+    return pool().size();
+  }
+
+  /// access to the worker threads; created on first use
+  corgi::tools::thread_pool& pool()
+  {
+    if(!_pool) _pool = std::make_unique<corgi::tools::thread_pool>();
+    return *_pool;
+  }
+
+  /// measure tile execution times in the for_each_* loops
+  //
+  // Timings are accumulated into Tile::work_timer and committed to
+  // Tile::measured_work (and thus to the default Tile::get_work) in update_work.
+  void set_work_timing(bool on) { _work_timing = on; }
+
+  bool get_work_timing() const { return _work_timing; }
+
+  /// Call f(tile) and record its execution time if work timing or tracing is on
+  //
+  // Only timed calls (solver kernels) are added to Tile::work_timer.
+  template<typename F>
+  void call_tile_kernel(Tile_t& tile, F& f, bool timed = true)
+  {
+    const bool timing  = _work_timing && timed;
+    const bool tracing = _timers.tracing();
+    if(!timing && !tracing) {
+      f(tile); 
+      return;
+    }
+
+    auto t0 = std::chrono::steady_clock::now();
+    f(tile); 
+    auto t1 = std::chrono::steady_clock::now();
+
+    if(timing) tile.record_work( std::chrono::duration<double>(t1 - t0).count() );
+    if(tracing) {
+      _timers.event("tile", 
+          std::chrono::duration<double>(t0.time_since_epoch()).count(),
+          std::chrono::duration<double>(t1.time_since_epoch()).count(),
+          static_cast<int64_t>(tile.cid));
+    }
+  }
+
+  /// Apply f(Tile&) to the given tiles using the worker threads
+  //
+  // Tiles are scheduled by their Tile::get_work estimate, largest first.
+  // Tile pointers are resolved before the loop so workers never modify
+  // the tile map; f may however read other tiles via get_tile/get_tileptr.
+  // f must not call MPI nor add/remove tiles.
+  template<typename F>
+  void for_each_tile(const std::vector<uint64_t>& cids, F&& f)
+  {
+    for_each_tile(cids, std::forward<F>(f), true);
+  }
+
+  /// for_each_tile whose calls are not added to the tile work
+  //
+  // For I/O and bookkeeping loops (e.g., serialization) that must not
+  // skew the work estimates of the load balancer.
+  template<typename F>
+  void for_each_tile_untimed(const std::vector<uint64_t>& cids, F&& f)
+  {
+    for_each_tile(cids, std::forward<F>(f), false);
+  }
+
+  private:
+
+  template<typename F>
+  void for_each_tile(const std::vector<uint64_t>& cids, F&& f, bool timed)
+  {
+    std::vector<Tile_t*> ptrs;
+    std::vector<double> weights;
+    ptrs.reserve(cids.size());
+    weights.reserve(cids.size());
+    for(auto cid : cids) {
+      auto& tile = get_tile(cid);
+      ptrs.push_back( &tile );
+      weights.push_back( tile.get_work() );
+    }
+
+    auto kernel = [&](size_t i) { call_tile_kernel(*ptrs[i], f, timed); };
+
+    _in_parallel_region = true;
+    try {
+      pool().parallel_for(weights, kernel);
+    } catch(...) {
+      _in_parallel_region = false;
+      throw;
+    }
+    _in_parallel_region = false;
+  }
+
+  public:
+
+  /// Apply f(Tile&) to all local tiles in parallel
+  template<typename F>
+  void for_each_local_tile(F&& f) { for_each_tile( get_local_tiles(), std::forward<F>(f) ); }
+
+  /// Apply f(Tile&) to all local boundary tiles in parallel
+  template<typename F>
+  void for_each_boundary_tile(F&& f) { for_each_tile( get_boundary_tiles(), std::forward<F>(f) ); }
+
+  /// Apply f(Tile&) to all local tiles without virtual neighbors in parallel
+  template<typename F>
+  void for_each_interior_tile(F&& f) { for_each_tile( get_interior_tiles(), std::forward<F>(f) ); }
+
+  /// Apply f(Tile&) to all virtual tiles in parallel
+  template<typename F>
+  void for_each_virtual_tile(F&& f) { for_each_tile( get_virtuals(), std::forward<F>(f) ); }
+
+  /// Apply f(Tile&) to all active local tiles in parallel
+  template<typename F>
+  void for_each_active_tile(F&& f) { for_each_tile( get_active_tiles(), std::forward<F>(f) ); }
+
+
+  // --------------------------------------------------
+  // active-region tracking
+
+  private:
+
+  /// tiles that the next send_data (boundary) and recv_data (virtual)
+  /// of a mode skip; set by exchange_activity of that mode
+  std::map<int, std::set<uint64_t>> _quiet_sends, _quiet_recvs;
+
+  /// remove and return the quiet tiles of a mode
+  static std::set<uint64_t> take_quiet(std::map<int, std::set<uint64_t>>& quiet, int mode)
+  {
+    std::set<uint64_t> ret;
+    auto it = quiet.find(mode);
+    if(it != quiet.end()) {
+      ret = std::move(it->second);
+      quiet.erase(it);
+    }
+    return ret;
+  }
+
+  public:
+
+  /// Return all local tiles that are active
+  std::vector<uint64_t> get_active_tiles(
+      const bool sorted=false ) {
+
+    std::vector<uint64_t> tile_list = get_tile_ids(sorted);
+    std::vector<uint64_t> ret;
+    ret.reserve(tile_list.size());
+
+    for(auto elem : tile_list) {
+      auto& c = *tiles.at( elem );
+      if(c.communication.owner == comm.rank() && c.active) ret.push_back(elem);
+    }
+    return ret;
+  }
+
+  /*! \brief Share activity flags with neighbor ranks and wake up tiles next to active ones
+   *
+   * Tile::active is maintained by the user, e.g., a solver that clears it
+   * when a tile did not change. This routine sends one byte per boundary
+   * tile to each virtual owner and then
+   *  - sets the flags of virtual tiles to those of their owners,
+   *  - activates local tiles that have an active neighbor, and
+   *  - makes the next send_data/recv_data of mode skip the tiles that
+   *    were inactive (the virtual copies of those are still up to date).
+   *
+   * The skip applies once and only to mode; other modes, e.g., a raw mode
+   * that moves whole tiles, still send every boundary tile. Neighbor ranks
+   * must call it at the same point. Without it activity has no effect on
+   * the messages. analyze_boundaries activates every tile and drops
+   * pending skips.
+   */
+  void exchange_activity(int mode)
+  {
+    using corgi::tools::phase;
+    auto timer = _timers.time(phase::exchange_activity);
+
+    // same order as in send_data/recv_data
+    std::map<int, std::vector<uint64_t> > send_tags, recv_tags;
+    for(auto cid : get_boundary_tiles() ) {
+      for(auto dest: get_tile(cid).virtual_owners) send_tags[dest].push_back(cid);
+    }
+    for(auto cid : get_virtuals() ) recv_tags[get_tile(cid).communication.owner].push_back(cid);
+    for(auto& elem : send_tags) sort(elem.second.begin(), elem.second.end());
+    for(auto& elem : recv_tags) sort(elem.second.begin(), elem.second.end());
+
+    std::map<int, std::vector<char> > sbufs, rbufs;
+    std::vector<mpi::request> reqs;
+
+    for(auto& [orig, cids] : recv_tags) {
+      auto& buf = rbufs[orig];
+      buf.resize(cids.size());
+      reqs.push_back( comm.irecv(orig, commType::ACTIVITY, buf.data(), static_cast<int>(buf.size())) );
+      _timers.count(phase::exchange_activity, 1, buf.size());
+    }
+
+    auto& quiet_sends = _quiet_sends[mode];
+    quiet_sends.clear();
+    for(auto& [dest, cids] : send_tags) {
+      auto& buf = sbufs[dest];
+      for(auto cid : cids) {
+        const bool a = get_tile(cid).active;
+        buf.push_back(static_cast<char>(a));
+        if(!a) quiet_sends.insert(cid);
+      }
+      reqs.push_back( comm.isend(dest, commType::ACTIVITY, buf.data(), static_cast<int>(buf.size())) );
+      _timers.sent(phase::exchange_activity, dest, 1, buf.size());
+    }
+
+    mpi::wait_all(reqs.begin(), reqs.end());
+
+    auto& quiet_recvs = _quiet_recvs[mode];
+    quiet_recvs.clear();
+    for(auto& [orig, cids] : recv_tags) {
+      const auto& buf = rbufs[orig];
+      for(size_t i=0; i<cids.size(); i++) {
+        get_tile(cids[i]).active = buf[i] != 0;
+        if(buf[i] == 0) quiet_recvs.insert(cids[i]);
+      }
+    }
+
+    // wake up; decided from the flags before the wake-up
+    std::vector<Tile_t*> woken;
+    for(auto& elem : tiles) {
+      auto& c = *elem.second;
+      if(!c.active) continue;
+
+      for(auto& indx : c.nhood()) {
+        auto it = tiles.find( id(indx) );
+        if(it == tiles.end()) continue;
+
+        auto& n = *it->second;
+        if(!n.active && n.communication.owner == comm.rank()) woken.push_back(&n);
+      }
+    }
+    for(auto t : woken) t->active = true;
+    _timers.tiles(phase::exchange_activity, tiles.size());
+  }
+
+
   // --------------------------------------------------
   // user-data message routines
 
@@ -1626,20 +2052,27 @@ class Grid
   //       this way methods can be extended for different types of send.
   void send_data(int mode)
   {
+    using corgi::tools::phase;
+    auto timer = _timers.time(phase::send_data);
+
     sent_data_messages[mode] = {};
 
     
+    // receivers know from exchange_activity that these are not coming
+    const auto quiet = take_quiet(_quiet_sends, mode);
+
     // re-order sends and compute mpi tags
     std::map<int, std::vector<uint64_t> > tags;
     for(auto cid : get_boundary_tiles() ) {
       auto& tile = get_tile(cid);
+      if(quiet.count(cid) > 0) continue;
 
-      // TODO proceed only if tile is active 
       for(auto dest: tile.virtual_owners) {
         tags[dest].push_back(cid);
       }
     }
     for(auto& elem : tags) sort(elem.second.begin(), elem.second.end());
+    _timers.tiles(phase::send_data, boundary_tile_list.size());
 
     // print
     //for(auto& elem : tags) {
@@ -1648,6 +2081,11 @@ class Grid
     //  std::cout << "\n";
     //}
 
+    if(get_codec(mode)) {
+      send_encoded_data(mode, tags);
+      return;
+    }
+
     int dest;
     uint64_t cid;
     for(auto& elem : tags) {
@@ -1656,6 +2094,7 @@ class Grid
         cid = elem.second[i];
         auto& tile = get_tile(cid);
         auto reqs = tile.send_data(comm, dest, mode, i);
+        _timers.sent(phase::send_data, dest, reqs.size(), tile.data_size(dest, mode));
 
         for(auto req : reqs) sent_data_messages.at(mode).push_back(req);
       }
@@ -1677,17 +2116,26 @@ class Grid
   //       this way they can be extended for different types of recv.
   void recv_data(int mode)
   {
+    using corgi::tools::phase;
+    auto timer = _timers.time(phase::recv_data);
+
     recv_data_messages[mode] = {};
+    recv_data_ranges[mode] = {};
+
+    // owner did not change these; see exchange_activity
+    const auto quiet = take_quiet(_quiet_recvs, mode);
 
     // re-order sends and compute mpi tags
     std::map<int, std::vector<uint64_t> > tags;
     for(auto cid : get_virtuals() ) {
       auto& tile = get_tile(cid);
+      set_halo_directions(tile);
+      if(quiet.count(cid) > 0) continue;
 
-      //TODO: proceed only if tile is active
       tags[tile.communication.owner].push_back(cid);
     }
     for(auto& elem : tags) sort(elem.second.begin(), elem.second.end());
+    for(auto& elem : tags) _timers.tiles(phase::recv_data, elem.second.size());
 
     // print
     //for(auto& elem : tags) {
@@ -1697,6 +2145,19 @@ class Grid
     //}
 
 
+    // encoded messages have unknown size; they are probed when waited
+    if(get_codec(mode)) {
+      recv_data_sources[mode] = {};
+      for(auto& elem : tags) {
+        for(int i = 0; i<(int)elem.second.size(); i++) {
+          recv_data_ranges.at(mode).emplace_back(elem.second[i], 0, 0);
+          recv_data_sources.at(mode).emplace_back(elem.first, codec_tag(mode, i));
+        }
+      }
+      recv_data_done[mode].assign(recv_data_ranges.at(mode).size(), 0);
+      return;
+    }
+
     int orig;
     uint64_t cid;
     for(auto& elem : tags) {
@@ -1705,8 +2166,11 @@ class Grid
         cid = elem.second[i];
         auto& tile = get_tile(cid);
         auto reqs = tile.recv_data(comm, orig, mode, i);
+        _timers.count(phase::recv_data, reqs.size());
 
+        size_t first = recv_data_messages.at(mode).size();
         for(auto req : reqs) recv_data_messages.at(mode).push_back(req);
+        recv_data_ranges.at(mode).emplace_back(cid, first, first + reqs.size());
       }
     }
 
@@ -1726,12 +2190,20 @@ class Grid
   /// barrier until all (primary) data is received
   void wait_data(int tag)
   {
+    auto timer = _timers.time(corgi::tools::phase::wait_data);
+
     //assert( tag < (int)recv_data_messages.size() );
     assert( sent_data_messages.count(tag) > 0 );
     assert( recv_data_messages.count(tag) > 0 );
     
-    mpi::wait_all( recv_data_messages[tag].begin(), recv_data_messages[tag].end() );
-    mpi::wait_all( sent_data_messages[tag].begin(), sent_data_messages[tag].end() );
+    if(get_codec(tag)) recv_encoded_data(tag);
+
+    if(_timers.tracing()) {
+      wait_data_traced(tag);
+    } else {
+      mpi::wait_all( recv_data_messages[tag].begin(), recv_data_messages[tag].end() );
+      mpi::wait_all( sent_data_messages[tag].begin(), sent_data_messages[tag].end() );
+    }
     //for(auto& req : recv_data_messages[tag]) req.wait();
 
     // vanilla MPI
@@ -1751,6 +2223,10 @@ class Grid
     // erase (do not force capacity change)
     sent_data_messages[tag] = {};
     recv_data_messages[tag] = {};
+    recv_data_ranges[tag] = {};
+    sent_data_buffers.erase(tag);
+    recv_data_sources.erase(tag);
+    recv_data_done.erase(tag);
 
     // erase and force clean
     //std::vector<mpi::request>().swap( sent_data_messages[tag] );
@@ -1758,31 +2234,1037 @@ class Grid
     
   }
 
+  private:
+
+  /// wait_data split into one wait per neighbor rank for the trace
+  //
+  // recv_data_ranges is ordered by the owner rank, so messages of one
+  // neighbor are contiguous.
+  void wait_data_traced(int tag)
+  {
+    auto& reqs   = recv_data_messages[tag];
+    auto& ranges = recv_data_ranges[tag];
+
+    size_t r = 0;
+    while(r < ranges.size()) {
+      const int orig = get_tile( std::get<0>(ranges[r]) ).communication.owner;
+      const size_t first = std::get<1>(ranges[r]);
+      size_t last = std::get<2>(ranges[r]);
+      for(r++; r < ranges.size() && get_tile( std::get<0>(ranges[r]) ).communication.owner == orig; r++) {
+        last = std::get<2>(ranges[r]);
+      }
+
+      if(first == last) continue; // codec modes are received in recv_encoded_data
+
+      const double t0 = corgi::tools::trace_recorder::now();
+      mpi::wait_all( reqs.begin() + first, reqs.begin() + last );
+      _timers.event("wait_recv", t0, corgi::tools::trace_recorder::now(), -1, orig);
+    }
+
+    const double t0 = corgi::tools::trace_recorder::now();
+    mpi::wait_all( sent_data_messages[tag].begin(), sent_data_messages[tag].end() );
+    _timers.event("wait_send", t0, corgi::tools::trace_recorder::now());
+  }
+
+  public:
+
+  /// Complete exchange of one mode: post recvs, send, and wait
+  void exchange_data(int mode)
+  {
+    recv_data(mode);
+    send_data(mode);
+    wait_data(mode);
+  }
+
+
+  /// Wait until the data of the v-th virtual tile of recv_data_ranges has arrived
+  //
+  // For codec modes the message is also decoded and unpacked into the tile.
+  void wait_recv(int mode, size_t v)
+  {
+    if(!get_codec(mode)) {
+      const auto& [cid, first, last] = recv_data_ranges.at(mode).at(v);
+      auto& reqs = recv_data_messages.at(mode);
+      mpi::wait_all( reqs.begin() + first, reqs.begin() + last );
+      return;
+    }
+
+    recv_encoded_tile(mode, v, true);
+  }
+
+  /// Non-blocking wait_recv; true once the data of the v-th virtual tile has arrived
+  //
+  // Lets the caller handle the tiles in the order their messages complete.
+  // Codec modes are polled with MPI_Improbe and unpacked like in wait_recv.
+  bool test_recv(int mode, size_t v)
+  {
+    if(!get_codec(mode)) {
+      const auto& [cid, first, last] = recv_data_ranges.at(mode).at(v);
+      auto& reqs = recv_data_messages.at(mode);
+      for(size_t r=first; r<last; r++) {
+        if(!reqs[r].test()) return false;
+      }
+      return true;
+    }
+
+    return recv_encoded_tile(mode, v, false);
+  }
+
+
+  // --------------------------------------------------
+  // message compression
+
+  private:
+
+  /// codecs of communication modes; other modes use Tile::send_data/recv_data
+  std::unordered_map<int, std::shared_ptr<corgi::tools::codec>> _codecs;
+
+  std::unordered_map<int, corgi::tools::codec_stats> _codec_stats;
+
+  /// decode buffer of the thread driving MPI
+  std::vector<char> _codec_scratch;
+
+
+  /// MPI tag of the i-th encoded message of a codec mode
+  //
+  // Raw modes tag tiles with their index i < num_cells() and the grid
+  // itself uses the commType tags, so codec tags start above both and every
+  // mode gets its own range. Mprobe can then never match the message of
+  // another mode. Throws if the worst case exceeds MPI_TAG_UB so that all
+  // ranks fail consistently.
+  int codec_tag(int mode, int i) const
+  {
+    const int64_t ncells = static_cast<int64_t>(num_cells());
+    const int64_t base   = std::max<int64_t>(ncells, commType::N_COMMTYPES);
+
+    int* tag_ub = nullptr;
+    int flag = 0;
+    MPI_Comm_get_attr(MPI_COMM_WORLD, MPI_TAG_UB, &tag_ub, &flag);
+    const int64_t ub = flag ? *tag_ub : 32767; // minimum guaranteed by the standard
+
+    if(mode < 0 || base + (static_cast<int64_t>(mode) + 1)*ncells - 1 > ub) {
+      throw std::out_of_range("corgi: codec mode " + std::to_string(mode) 
+          + " does not fit into the MPI tag range");
+    }
+    return static_cast<int>(base + static_cast<int64_t>(mode)*ncells + i);
+  }
+
+  /// pack, encode (threaded), and send tiles of a codec mode
+  void send_encoded_data(int mode, const std::map<int, std::vector<uint64_t>>& tags)
+  {
+    const auto& c = *get_codec(mode);
+
+    // (tile, dest, tag) of every message
+    std::vector<std::tuple<Tile_t*, int, int>> msgs;
+    for(auto& elem : tags) {
+      for(int i = 0; i<(int)elem.second.size(); i++) {
+        msgs.emplace_back( &get_tile(elem.second[i]), elem.first, codec_tag(mode, i) );
+      }
+    }
+
+    auto& bufs = sent_data_buffers[mode];
+    bufs.clear();
+    bufs.resize(msgs.size());
+    std::vector<size_t> raw_bytes(msgs.size(), 0);
+
+    auto t0 = std::chrono::steady_clock::now();
+
+    _in_parallel_region = true;
+    try {
+      pool().parallel_for(msgs.size(), [&](size_t m) {
+        thread_local std::vector<char> raw;
+        raw.clear();
+
+        auto& [tile, dest, tag] = msgs[m];
+        if(c.identity()) {
+          tile->pack_header(bufs[m], dest, mode);
+          tile->pack_data(bufs[m], dest, mode);
+          raw_bytes[m] = bufs[m].size();
+          return;
+        }
+
+        // [header size][raw header][encoded payload]
+        thread_local std::vector<char> enc;
+        auto& out = bufs[m];
+        out.resize(sizeof(uint64_t));
+        tile->pack_header(out, dest, mode);
+        const uint64_t nh = out.size() - sizeof(uint64_t);
+        std::memcpy(out.data(), &nh, sizeof(uint64_t));
+
+        tile->pack_data(raw, dest, mode);
+        c.encode(raw.data(), raw.size(), enc);
+        out.insert(out.end(), enc.begin(), enc.end());
+        raw_bytes[m] = nh + raw.size();
+      });
+    } catch(...) {
+      _in_parallel_region = false;
+      throw;
+    }
+    _in_parallel_region = false;
+
+    auto t1 = std::chrono::steady_clock::now();
+
+    auto& stats = _codec_stats[mode];
+    stats.encode_time   += std::chrono::duration<double>(t1 - t0).count();
+    stats.sent_messages += msgs.size();
+
+    for(size_t m=0; m<msgs.size(); m++) {
+      auto& [tile, dest, tag] = msgs[m];
+      sent_data_messages.at(mode).push_back( 
+          comm.isend(dest, tag, bufs[m].data(), static_cast<int>(bufs[m].size())) );
+      _timers.sent(corgi::tools::phase::send_data, dest, 1, bufs[m].size());
+
+      stats.raw_bytes_sent     += raw_bytes[m];
+      stats.encoded_bytes_sent += bufs[m].size();
+    }
+  }
+
+  /// receive the encoded message of the v-th virtual tile
+  //
+  // Blocks until it arrives, or returns false if it has not arrived and
+  // block is false.
+  bool probe_encoded_data(int mode, size_t v, std::vector<char>& buf, bool block = true)
+  {
+    const auto [orig, tag] = recv_data_sources.at(mode).at(v);
+
+    const double t0 = corgi::tools::trace_recorder::now();
+
+    MPI_Message msg;
+    MPI_Status status;
+    if(block) {
+      MPI_Mprobe(orig, tag, MPI_COMM_WORLD, &msg, &status);
+    } else {
+      int flag = 0;
+      MPI_Improbe(orig, tag, MPI_COMM_WORLD, &flag, &msg, &status);
+      if(!flag) return false;
+    }
+
+    int count = 0;
+    MPI_Get_count(&status, MPI_CHAR, &count);
+    buf.resize(count);
+    MPI_Mrecv(buf.data(), count, MPI_CHAR, &msg, MPI_STATUS_IGNORE);
+
+    auto& stats = _codec_stats[mode];
+    stats.recv_messages      += 1;
+    stats.encoded_bytes_recv += buf.size();
+
+    _timers.count(corgi::tools::phase::wait_data, 1, buf.size());
+    if(_timers.tracing()) {
+      const uint64_t cid = std::get<0>( recv_data_ranges.at(mode)[v] );
+      _timers.event("wait_recv", t0, corgi::tools::trace_recorder::now(), static_cast<int64_t>(cid), orig);
+    }
+
+    return true;
+  }
+
+  /// receive, decode, and unpack the v-th virtual tile of a codec mode on this thread
+  //
+  // Returns false if block is false and the message has not arrived.
+  bool recv_encoded_tile(int mode, size_t v, bool block)
+  {
+    auto& done = recv_data_done.at(mode);
+    if(done.at(v)) return true;
+
+    auto t0 = std::chrono::steady_clock::now();
+
+    std::vector<char> buf;
+    if(!probe_encoded_data(mode, v, buf, block)) return false;
+    const size_t raw_bytes = decode_and_unpack(mode, v, buf, _codec_scratch);
+    done[v] = 1;
+
+    auto t1 = std::chrono::steady_clock::now();
+    auto& stats = _codec_stats[mode];
+    stats.decode_time    += std::chrono::duration<double>(t1 - t0).count();
+    stats.raw_bytes_recv += raw_bytes;
+
+    return true;
+  }
+
+  /// decode buf into scratch and hand it to the v-th virtual tile
+  //
+  // Only touches the tile and the scratch buffer so it can run on any thread.
+  size_t decode_and_unpack(int mode, size_t v, const std::vector<char>& buf, std::vector<char>& scratch)
+  {
+    const uint64_t cid = std::get<0>( recv_data_ranges.at(mode)[v] );
+    const int orig     = recv_data_sources.at(mode)[v].first;
+
+    const auto& c = *get_codec(mode);
+    if(c.identity()) {
+      get_tile(cid).unpack_data(buf.data(), buf.size(), orig, mode);
+      return buf.size();
+    }
+
+    // raw header goes back in front of the decoded payload
+    uint64_t nh = 0;
+    if(buf.size() >= sizeof(uint64_t)) std::memcpy(&nh, buf.data(), sizeof(uint64_t));
+    if(buf.size() < sizeof(uint64_t) || nh > buf.size() - sizeof(uint64_t)) {
+      throw std::length_error("corgi: truncated encoded message");
+    }
+    const char* header = buf.data() + sizeof(uint64_t);
+
+    c.decode(header + nh, buf.size() - sizeof(uint64_t) - nh, scratch);
+    scratch.insert(scratch.begin(), header, header + nh);
+    get_tile(cid).unpack_data(scratch.data(), scratch.size(), orig, mode);
+
+    return scratch.size();
+  }
+
+  /// receive all pending messages of a codec mode; decode them threaded
+  void recv_encoded_data(int mode)
+  {
+    auto& done = recv_data_done.at(mode);
+
+    auto t0 = std::chrono::steady_clock::now();
+
+    std::vector<size_t> pending;
+    for(size_t v=0; v<done.size(); v++) if(!done[v]) pending.push_back(v);
+
+    std::vector<std::vector<char>> bufs(pending.size());
+    for(size_t p=0; p<pending.size(); p++) probe_encoded_data(mode, pending[p], bufs[p]);
+
+    std::vector<size_t> raw_bytes(pending.size(), 0);
+    _in_parallel_region = true;
+    try {
+      pool().parallel_for(pending.size(), [&](size_t p) {
+        thread_local std::vector<char> scratch;
+        raw_bytes[p] = decode_and_unpack(mode, pending[p], bufs[p], scratch);
+      });
+    } catch(...) {
+      _in_parallel_region = false;
+      throw;
+    }
+    _in_parallel_region = false;
+
+    auto t1 = std::chrono::steady_clock::now();
+
+    auto& stats = _codec_stats[mode];
+    stats.decode_time += std::chrono::duration<double>(t1 - t0).count();
+    for(auto n : raw_bytes) stats.raw_bytes_recv += n;
+    for(auto v : pending) done[v] = 1;
+  }
+
+
+  public:
+
+  /// Encode all messages of a communication mode with a codec
+  //
+  // Tiles are then exchanged with Tile::pack_data/unpack_data instead of
+  // Tile::send_data/recv_data and the grid sends one encoded message per
+  // (tile, destination). Set nullptr to go back to raw messages. All ranks
+  // must use the same codec for a mode. Encoded messages carry the mode in
+  // their MPI tag (see codec_tag), so modes must be non-negative and small
+  // enough for (mode + 2)*num_cells() to fit below MPI_TAG_UB.
+  void set_codec(int mode, std::shared_ptr<corgi::tools::codec> c)
+  {
+    if(c) {
+      _codecs[mode] = std::move(c);
+    } else {
+      _codecs.erase(mode);
+    }
+  }
+
+  /// codec of a mode; nullptr if messages are sent raw
+  std::shared_ptr<corgi::tools::codec> get_codec(int mode) const
+  {
+    auto it = _codecs.find(mode);
+    return it == _codecs.end() ? nullptr : it->second;
+  }
+
+  /// accumulated message statistics of a codec mode
+  corgi::tools::codec_stats get_codec_stats(int mode) const
+  {
+    auto it = _codec_stats.find(mode);
+    return it == _codec_stats.end() ? corgi::tools::codec_stats() : it->second;
+  }
+
+  void reset_codec_stats() { _codec_stats.clear(); }
+
+
+  /// Color of a tile along an axis of length N for the direction loops
+  //
+  // Neighbors along the axis always get a different color, also across the
+  // periodic boundary (odd N needs a third color for the last slab).
+  static size_t moore_color(size_t i, size_t N)
+  {
+    if( (N % 2 == 1) && (i == N-1) ) return 2;
+    return i % 2;
+  }
 
   /// See corgi::Tile::pairwise_moore_communication.
+  //
+  // Pre- and postludes run in parallel over all tiles. Within one direction
+  // the local tiles are split into colors along an axis the direction 
+  // points to, so that no tile is written while some other tile reads it.
+  // Colors are then processed one after another, each in parallel.
   void
   pairwise_moore_communication(const int mode) {
-      // Loops could potentially be parallelized.
-    
-      for (const auto tile_id : get_tile_ids()) {
-          auto& tile = get_tile(tile_id);
+      using corgi::tools::phase;
+      auto timer = _timers.time(phase::pairwise_moore_communication);
+
+      for_each_tile_untimed(get_tile_ids(), [mode](Tile_t& tile) {
           tile.pairwise_moore_communication_prelude(mode);
-      }
+      });
+
+      const auto local_ids = get_local_tiles();
+      const bool serial = pool().size() == 1;
+      _timers.tiles(phase::pairwise_moore_communication, local_ids.size());
 
       for (const auto& dir : corgi::ca::moore_neighborhood<D>()) {
-          for (const auto tile_id : get_local_tiles()) {
-              auto& tile = get_tile(tile_id);
+          const auto array_dir = corgi::internals::into_array(dir);
 
-              const auto& other_tile = get_tile(id(tile.neighs(dir)));
-              const auto array_dir = corgi::internals::into_array(dir);
-              tile.pairwise_moore_communication(other_tile, array_dir, mode);
+          // color along an axis with more than one tile; if there is none,
+          // every tile is its own neighbor and needs no coloring at all
+          size_t axis = D;
+          for (size_t i = 0; i < D; i++) {
+              if (array_dir[i] != 0 && _lengths[i] > 1) { axis = i; break; }
+          }
+
+          std::array<std::vector<uint64_t>, 3> colors;
+          for (const auto tile_id : local_ids) {
+              const auto ind = corgi::internals::into_array(get_tile(tile_id).index);
+              const size_t c = (serial || axis == D) ? 0 : moore_color(ind[axis], _lengths[axis]);
+              colors[c].push_back(tile_id);
+          }
+
+          for (const auto& color : colors) {
+              for_each_tile_untimed(color, [&](Tile_t& tile) {
+                  const auto& other_tile = get_tile(id(tile.neighs(dir)));
+                  tile.pairwise_moore_communication(other_tile, array_dir, mode);
+              });
           }
       }
 
-      for (const auto tile_id : get_tile_ids()) {
-          auto& tile = get_tile(tile_id);
+      for_each_tile_untimed(get_tile_ids(), [mode](Tile_t& tile) {
           tile.pairwise_moore_communication_postlude(mode);
+      });
+  }
+
+
+  // --------------------------------------------------
+  // instrumentation
+
+  /// timers and counters of the public phases on this rank
+  const corgi::tools::phase_timers& get_phase_stats() const { return _timers; }
+
+  void reset_phase_stats() { _timers.clear(); }
+
+  /// min/max/mean of the phase counters over all ranks (collective)
+  //
+  // The max/mean ratio of a phase time shows load imbalance; e.g., a 
+  // large wait_data imbalance means some ranks wait for slow neighbors.
+  std::vector<corgi::tools::phase_summary> reduce_phase_stats() const
+  {
+    using corgi::tools::phase;
+    constexpr size_t P = corgi::tools::phase_timers::num_phases;
+    constexpr size_t F = 5; // calls, time, messages, bytes, tiles
+
+    std::vector<double> loc(P*F), vmin(P*F), vmax(P*F), vsum(P*F);
+    for(size_t p=0; p<P; p++) {
+      const auto& c = _timers.get( static_cast<phase>(p) );
+      loc[F*p + 0] = static_cast<double>(c.calls);
+      loc[F*p + 1] = c.time;
+      loc[F*p + 2] = static_cast<double>(c.messages);
+      loc[F*p + 3] = static_cast<double>(c.bytes);
+      loc[F*p + 4] = static_cast<double>(c.tiles);
+    }
+
+    const int n = static_cast<int>(loc.size());
+    MPI_Allreduce(loc.data(), vmin.data(), n, MPI_DOUBLE, MPI_MIN, MPI_COMM_WORLD);
+    MPI_Allreduce(loc.data(), vmax.data(), n, MPI_DOUBLE, MPI_MAX, MPI_COMM_WORLD);
+    MPI_Allreduce(loc.data(), vsum.data(), n, MPI_DOUBLE, MPI_SUM, MPI_COMM_WORLD);
+
+    std::vector<corgi::tools::phase_summary> ret(P);
+    for(size_t p=0; p<P; p++) {
+      ret[p].name = corgi::tools::phase_name( static_cast<phase>(p) );
+
+      corgi::tools::rank_summary* fields[F] = 
+        { &ret[p].calls, &ret[p].time, &ret[p].messages, &ret[p].bytes, &ret[p].tiles };
+      for(size_t f=0; f<F; f++) {
+        fields[f]->min  = vmin[F*p + f];
+        fields[f]->max  = vmax[F*p + f];
+        fields[f]->mean = vsum[F*p + f]/comm.size();
+      }
+    }
+    return ret;
+  }
+
+
+  /// Start recording a timeline of phases, tile kernels, and waits
+  //
+  // Keeps the last capacity events of every worker thread; call after
+  // set_num_threads. Written with write_trace.
+  void start_trace(size_t capacity = 65536)
+  {
+    assert(!_in_parallel_region);
+    _timers.trace().start(pool().size(), capacity);
+  }
+
+  void stop_trace() { _timers.trace().stop(); }
+
+  /// Write recorded events of all ranks as Chrome Trace Event JSON (collective)
+  //
+  // Open with chrome://tracing or ui.perfetto.dev; every rank is a process
+  // and every worker thread a track. Clocks are aligned to the MPI_Wtime
+  // of rank 0 (to within one broadcast latency). The events of the ranks
+  // are streamed to rank 0, which writes the file, one rank at a time.
+  void write_trace(const std::string& fname)
+  {
+    assert(!_in_parallel_region);
+    const auto& tr = _timers.trace();
+    const int rank = comm.rank();
+
+    // shift from the local steady clock to MPI_Wtime of rank 0
+    MPI_Barrier(MPI_COMM_WORLD);
+    double root_wtime = MPI_Wtime();
+    MPI_Bcast(&root_wtime, 1, MPI_DOUBLE, 0, MPI_COMM_WORLD);
+    const double shift = root_wtime - corgi::tools::trace_recorder::now();
+
+    std::vector<std::vector<corgi::tools::trace_event>> events(tr.num_threads());
+    double tmin = std::numeric_limits<double>::max();
+    for(size_t t=0; t<events.size(); t++) {
+      events[t] = tr.events(t);
+      for(auto& e : events[t]) tmin = std::min(tmin, e.begin + shift);
+    }
+    MPI_Allreduce(MPI_IN_PLACE, &tmin, 1, MPI_DOUBLE, MPI_MIN, MPI_COMM_WORLD);
+
+    uint64_t dropped = tr.dropped();
+    MPI_Allreduce(MPI_IN_PLACE, &dropped, 1, MPI_UINT64_T, MPI_SUM, MPI_COMM_WORLD);
+
+    // JSON events of this rank; timestamps in microseconds
+    std::string chunk;
+    char line[512];
+    auto append = [&](int n) { chunk.append(chunk.empty() ? "" : ",\n").append(line, std::min<size_t>(n, sizeof(line)-1)); };
+
+    append( std::snprintf(line, sizeof(line),
+          R"({"name":"process_name","ph":"M","pid":%d,"args":{"name":"rank %d"}})", rank, rank) );
+    append( std::snprintf(line, sizeof(line),
+          R"({"name":"process_sort_index","ph":"M","pid":%d,"args":{"sort_index":%d}})", rank, rank) );
+
+    for(size_t t=0; t<events.size(); t++) {
+      append( std::snprintf(line, sizeof(line),
+            R"({"name":"thread_name","ph":"M","pid":%d,"tid":%zu,"args":{"name":"worker %zu"}})", rank, t, t) );
+
+      for(auto& e : events[t]) {
+        append( std::snprintf(line, sizeof(line),
+              R"({"name":"%s","cat":"corgi","ph":"X","pid":%d,"tid":%zu,"ts":%.3f,"dur":%.3f,"args":{"cid":%lld,"peer":%d}})",
+              e.name, rank, t, 1e6*(e.begin + shift - tmin), 1e6*(e.end - e.begin),
+              static_cast<long long>(e.cid), e.peer) );
+      }
+    }
+
+    // rank 0 opens the file first so that every rank throws if it fails
+    std::ofstream f;
+    int ok = 1;
+    if(rank == 0) {
+      f.open(fname);
+      ok = f ? 1 : 0;
+    }
+    MPI_Bcast(&ok, 1, MPI_INT, 0, MPI_COMM_WORLD);
+    if(!ok) throw std::runtime_error("corgi: can not open trace file " + fname);
+
+    // stream the chunks to rank 0 one rank at a time; chunks can exceed
+    // the int range of MPI counts so they are split into pieces
+    uint64_t n = chunk.size();
+    if(rank != 0) {
+      MPI_Send(&n, 1, MPI_UINT64_T, 0, commType::TRACE, MPI_COMM_WORLD);
+      for(uint64_t first=0; first<n; first += _io_chunk) {
+        const uint64_t count = std::min(_io_chunk, n - first);
+        MPI_Send(chunk.data() + first, static_cast<int>(count), MPI_CHAR, 0, commType::TRACE, MPI_COMM_WORLD);
+      }
+      return;
+    }
+
+    f << "{\"displayTimeUnit\":\"ms\",\n"
+      << "\"otherData\":{\"ranks\":" << comm.size() << ",\"dropped_events\":" << dropped << "},\n"
+      << "\"traceEvents\":[\n";
+    f.write(chunk.data(), chunk.size());
+
+    std::vector<char> buf;
+    for(int r=1; r<comm.size(); r++) {
+      MPI_Recv(&n, 1, MPI_UINT64_T, r, commType::TRACE, MPI_COMM_WORLD, MPI_STATUS_IGNORE);
+      buf.resize( std::min(_io_chunk, n) );
+
+      f << ",\n";
+      for(uint64_t first=0; first<n; first += _io_chunk) {
+        const uint64_t count = std::min(_io_chunk, n - first);
+        MPI_Recv(buf.data(), static_cast<int>(count), MPI_CHAR, r, commType::TRACE, MPI_COMM_WORLD, MPI_STATUS_IGNORE);
+        f.write(buf.data(), count);
+      }
+    }
+    f << "\n]}\n";
+
+    if(!f) throw std::runtime_error("corgi: can not write trace file " + fname);
+  }
+
+
+  // --------------------------------------------------
+  // partition quality
+
+  /// Rank x rank message counts and volumes of a mode, and tile counts (collective)
+  //
+  // Computed from the lists of the last analyze_boundaries without sending 
+  // any data; call analyze_boundaries after ownership changes (e.g., 
+  // adoption_council2) to compare partitions.
+  corgi::io::comm_report make_comm_report(int mode = 0)
+  {
+    const int n = comm.size();
+    const size_t N = static_cast<size_t>(n);
+
+    // codec modes send what pack_data gives
+    const bool codec = get_codec(mode) != nullptr;
+
+    // my row: messages[n], bytes[n], local, boundary, virtual
+    std::vector<uint64_t> row(2*N + 3, 0);
+    for(auto&& elem : boundary_tile_list) {
+      const auto& tile = get_tile(elem.first);
+      for(int dest : elem.second) {
+        row[dest]     += 1;
+        row[N + dest] += codec ? tile.packed_size(dest, mode) : tile.data_size(dest, mode);
+      }
+    }
+    row[2*N]     = get_local_tiles().size();
+    row[2*N + 1] = boundary_tile_list.size();
+    for(auto&& elem : virtual_tile_list) row[2*N + 2] += elem.second.size();
+
+    std::vector<uint64_t> all(row.size()*N);
+    MPI_Allgather(row.data(), static_cast<int>(row.size()), MPI_UINT64_T, 
+                  all.data(), static_cast<int>(row.size()), MPI_UINT64_T, MPI_COMM_WORLD);
+
+    corgi::io::comm_report rep;
+    rep.ranks = n;
+    rep.mode  = mode;
+    rep.messages.resize(N*N);
+    rep.bytes.resize(N*N);
+    for(size_t r=0; r<N; r++) {
+      const uint64_t* rr = &all[r*row.size()];
+      std::copy(rr,     rr + N,   rep.messages.begin() + r*N);
+      std::copy(rr + N, rr + 2*N, rep.bytes.begin()    + r*N);
+      rep.local_tiles.push_back(    rr[2*N]     );
+      rep.boundary_tiles.push_back( rr[2*N + 1] );
+      rep.virtual_tiles.push_back(  rr[2*N + 2] );
+    }
+    return rep;
+  }
+
+  /// Write make_comm_report(mode) as <prefix>_ranks.csv and <prefix>_pairs.csv (collective)
+  void write_comm_report(const std::string& prefix, int mode = 0)
+  {
+    auto rep = make_comm_report(mode);
+    if(comm.rank() == 0) rep.write_csv(prefix);
+  }
+
+
+  // --------------------------------------------------
+  // checkpoints
+  private:
+
+  /// largest chunk given to a single MPI-IO call (count is an int)
+  static constexpr uint64_t _io_chunk = INT_MAX/2;
+
+  static void check_mpi_io(int err, const std::string& what)
+  {
+    if(err == MPI_SUCCESS) return;
+
+    char msg[MPI_MAX_ERROR_STRING];
+    int len = 0;
+    MPI_Error_string(err, msg, &len);
+    throw std::runtime_error("corgi checkpoint: " + what + ": " + std::string(msg, len));
+  }
+
+  /// collective write of a (possibly >2GB) local buffer at offset
+  //
+  // After a failed chunk the rank keeps joining the collective calls with
+  // empty chunks and throws at the end, so that the others do not hang.
+  static void write_at_all(MPI_File fh, uint64_t offset, const char* buf, uint64_t size)
+  {
+    uint64_t nchunks = (size + _io_chunk - 1)/_io_chunk, max_chunks = 0;
+    MPI_Allreduce(&nchunks, &max_chunks, 1, MPI_UINT64_T, MPI_MAX, MPI_COMM_WORLD);
+
+    int err = MPI_SUCCESS;
+    for(uint64_t c=0; c<max_chunks; c++) {
+      uint64_t first = std::min(c*_io_chunk, size);
+      uint64_t count = err == MPI_SUCCESS ? std::min(_io_chunk, size - first) : 0;
+      int e = MPI_File_write_at_all(fh, offset + first, buf + first, 
+            static_cast<int>(count), MPI_BYTE, MPI_STATUS_IGNORE);
+      if(err == MPI_SUCCESS) err = e;
+    }
+    check_mpi_io(err, "write");
+  }
+
+  /// independent write of a (possibly >2GB) buffer at offset
+  static void write_at(MPI_File fh, uint64_t offset, const char* buf, uint64_t size)
+  {
+    for(uint64_t first=0; first<size; first += _io_chunk) {
+      uint64_t count = std::min(_io_chunk, size - first);
+      check_mpi_io( MPI_File_write_at(fh, offset + first, buf + first, 
+            static_cast<int>(count), MPI_BYTE, MPI_STATUS_IGNORE), "write");
+    }
+  }
+
+  /// throw if a read returned fewer bytes than asked (truncated file)
+  static void check_read_count(const MPI_Status& status, uint64_t count)
+  {
+    int n = 0;
+    MPI_Get_count(&status, MPI_BYTE, &n);
+    if(n < 0 || static_cast<uint64_t>(n) != count) {
+      throw std::runtime_error("corgi checkpoint: file is truncated");
+    }
+  }
+
+  /// independent read of a (possibly >2GB) buffer at offset
+  static void read_at(MPI_File fh, uint64_t offset, char* buf, uint64_t size)
+  {
+    MPI_Status status;
+    for(uint64_t first=0; first<size; first += _io_chunk) {
+      uint64_t count = std::min(_io_chunk, size - first);
+      check_mpi_io( MPI_File_read_at(fh, offset + first, buf + first, 
+            static_cast<int>(count), MPI_BYTE, &status), "read");
+      check_read_count(status, count);
+    }
+  }
+
+  /// collective read of a (possibly >2GB) buffer at offset; same size on every rank
+  //
+  // Errors are thrown only after all chunks as in write_at_all.
+  static void read_at_all(MPI_File fh, uint64_t offset, char* buf, uint64_t size)
+  {
+    MPI_Status status;
+    std::exception_ptr err;
+    for(uint64_t first=0; first<size; first += _io_chunk) {
+      uint64_t count = err ? 0 : std::min(_io_chunk, size - first);
+      int e = MPI_File_read_at_all(fh, offset + first, buf + first, 
+            static_cast<int>(count), MPI_BYTE, &status);
+      if(err) continue;
+      try {
+        check_mpi_io(e, "read");
+        check_read_count(status, count);
+      } catch(...) {
+        err = std::current_exception();
+      }
+    }
+    if(err) std::rethrow_exception(err);
+  }
+
+  /// Collectively agree whether any rank failed; if so close fh and throw everywhere
+  //
+  // Ranks that failed re-throw their own error, the others a generic one.
+  static void agree_on_error(std::exception_ptr err, MPI_File& fh)
+  {
+    int failed = err ? 1 : 0, any = 0;
+    MPI_Allreduce(&failed, &any, 1, MPI_INT, MPI_MAX, MPI_COMM_WORLD);
+    if(!any) return;
+
+    MPI_File_close(&fh);
+    if(err) std::rethrow_exception(err);
+    throw std::runtime_error("corgi checkpoint: I/O failed on another rank");
+  }
+
+  public:
+
+  /// number of cids, i.e., product of grid lengths
+  uint64_t num_cells() const 
+  {
+    uint64_t n = 1;
+    for(size_t i=0; i<D; i++) n *= _lengths[i];
+    return n;
+  }
+
+  /// checkpoint header filled with the grid configuration
+  corgi::io::checkpoint_header make_checkpoint_header(int64_t step)
+  {
+    auto header = corgi::io::make_header(D, num_cells());
+    for(size_t i=0; i<D; i++) {
+      header.lengths[i] = _lengths[i];
+      header.mins[i]    = _mins[i];
+      header.maxs[i]    = _maxs[i];
+    }
+    header.step      = step;
+    header.num_ranks = comm.size();
+
+    return header;
+  }
+
+  /// checkpoint metadata of a tile; payload location is left empty
+  corgi::io::tile_record make_tile_record(Tile_t& tile)
+  {
+    corgi::io::tile_record r;
+    std::memset(&r, 0, sizeof(r));
+
+    auto ind = corgi::internals::into_array(tile.index);
+    r.cid   = tile.cid;
+    r.owner = tile.communication.owner;
+    for(size_t d=0; d<D; d++) {
+      r.indices[d] = static_cast<int32_t>(ind[d]);
+      r.mins[d]    = tile.mins[d];
+      r.maxs[d]    = tile.maxs[d];
+    }
+    r.work = tile.measured_work;
+
+    return r;
+  }
+
+  /// Collectively write the full grid state into a single file
+  //
+  // Stores grid configuration, mpi_grid, work_grid, metadata of all
+  // local tiles, and their payloads from Tile::serialize (see 
+  // corgi/io/checkpoint_format.h). Ranks write their payloads into 
+  // disjoint regions given by a prefix sum of the payload sizes.
+  void write_checkpoint(const std::string& fname, int64_t step = 0)
+  {
+    const uint64_t ncells = num_cells();
+    auto header = make_checkpoint_header(step);
+
+    // serialize payloads (threaded over tiles)
+    const auto local_ids = get_local_tiles(true);
+    std::vector< std::vector<char> > payloads(local_ids.size());
+    std::unordered_map<uint64_t, size_t> slot;
+    for(size_t i=0; i<local_ids.size(); i++) slot[ local_ids[i] ] = i;
+
+    for_each_tile_untimed(local_ids, [&payloads, &slot](Tile_t& tile) {
+        tile.serialize( payloads[ slot.at(tile.cid) ] );
+    });
+
+    uint64_t local_bytes = 0;
+    for(auto& p : payloads) local_bytes += p.size();
+
+    // my payload region
+    uint64_t base = 0, total_bytes = 0;
+    MPI_Exscan(&local_bytes, &base, 1, MPI_UINT64_T, MPI_SUM, MPI_COMM_WORLD);
+    if(comm.rank() == 0) base = 0; // undefined on first rank
+    MPI_Allreduce(&local_bytes, &total_bytes, 1, MPI_UINT64_T, MPI_SUM, MPI_COMM_WORLD);
+
+    // tile records of my tiles
+    std::vector<corgi::io::tile_record> records(local_ids.size());
+    uint64_t offset = header.payload_offset + base;
+    for(size_t i=0; i<local_ids.size(); i++) {
+      auto& r  = records[i];
+      r        = make_tile_record( get_tile(local_ids[i]) );
+      r.offset = offset;
+      r.size   = payloads[i].size();
+      offset  += payloads[i].size();
+    }
+
+    // collect all records to master; counted in records, not bytes
+    MPI_Datatype record_type;
+    MPI_Type_contiguous(sizeof(corgi::io::tile_record), MPI_BYTE, &record_type);
+    MPI_Type_commit(&record_type);
+
+    int nlocal = static_cast<int>(records.size());
+    std::vector<int> counts(comm.size()), displs(comm.size(), 0);
+    MPI_Gather(&nlocal, 1, MPI_INT, counts.data(), 1, MPI_INT, 0, MPI_COMM_WORLD);
+    for(int r=1; r<comm.size(); r++) displs[r] = displs[r-1] + counts[r-1];
+
+    std::vector<corgi::io::tile_record> all_records;
+    if(comm.rank() == 0) all_records.resize( displs.back() + counts.back() );
+    MPI_Gatherv(records.data(), nlocal, record_type, 
+        all_records.data(), counts.data(), displs.data(), record_type, 
+        0, MPI_COMM_WORLD);
+    MPI_Type_free(&record_type);
+
+    MPI_File fh;
+    check_mpi_io( MPI_File_open(MPI_COMM_WORLD, fname.c_str(), 
+          MPI_MODE_CREATE | MPI_MODE_WRONLY, MPI_INFO_NULL, &fh), "open " + fname);
+    check_mpi_io( MPI_File_set_size(fh, 0), "truncate");
+
+    // master writes metadata
+    std::exception_ptr err;
+    if(comm.rank() == 0) try {
+      header.num_tiles = all_records.size();
+      header.file_size = header.payload_offset + total_bytes;
+
+      // cid-indexed table; missing tiles have owner -1
+      std::vector<corgi::io::tile_record> table(ncells);
+      std::memset(table.data(), 0, table.size()*sizeof(corgi::io::tile_record));
+      for(uint64_t c=0; c<ncells; c++) {
+        table[c].cid   = c;
+        table[c].owner = -1;
       }
+      for(auto& r : all_records) table[r.cid] = r;
+
+      std::vector<int32_t> owners( _mpi_grid.serialize() );
+      std::vector<double>  work( _work_grid.serialize() );
+
+      write_at(fh, 0,                        reinterpret_cast<const char*>(&header), sizeof(header));
+      write_at(fh, header.mpi_grid_offset,   reinterpret_cast<const char*>(owners.data()), ncells*sizeof(int32_t));
+      write_at(fh, header.work_grid_offset,  reinterpret_cast<const char*>(work.data()),   ncells*sizeof(double));
+      write_at(fh, header.tile_table_offset, reinterpret_cast<const char*>(table.data()),  
+          ncells*sizeof(corgi::io::tile_record));
+    } catch(...) {
+      err = std::current_exception();
+    }
+    agree_on_error(err, fh);
+
+    // everybody writes payloads collectively
+    std::vector<char> buffer;
+    buffer.reserve(local_bytes);
+    for(auto& p : payloads) buffer.insert(buffer.end(), p.begin(), p.end());
+
+    try {
+      write_at_all(fh, header.payload_offset + base, buffer.data(), buffer.size());
+    } catch(...) {
+      err = std::current_exception();
+    }
+    agree_on_error(err, fh);
+
+    check_mpi_io( MPI_File_close(&fh), "close");
+  }
+
+
+  /// Collectively restore the grid state from a checkpoint file
+  //
+  // All existing tiles are removed. Tiles are created with the factory
+  // and their payloads are given to Tile::deserialize. If the file was 
+  // written with a different number of ranks, tiles are re-partitioned 
+  // into contiguous cid ranges of equal stored work_grid. Returns the
+  // stored step.
+  //
+  // NOTE: virtual tiles are not restored; call analyze_boundaries,
+  // send_tiles and recv_tiles afterwards as after any load balancing.
+  int64_t read_checkpoint(
+      const std::string& fname,
+      const std::function<Tileptr()>& factory = [](){ return std::make_shared<Tile_t>(); } )
+  {
+    assert(!_in_parallel_region);
+
+    MPI_File fh;
+    check_mpi_io( MPI_File_open(MPI_COMM_WORLD, fname.c_str(), 
+          MPI_MODE_RDONLY, MPI_INFO_NULL, &fh), "open " + fname);
+
+    // a short file leaves the header zeroed and thus invalid
+    corgi::io::checkpoint_header header{};
+    MPI_Status status;
+    check_mpi_io( MPI_File_read_at_all(fh, 0, &header, sizeof(header), 
+          MPI_BYTE, &status), "read header");
+
+    int nread = 0;
+    MPI_Get_count(&status, MPI_BYTE, &nread);
+    if(nread != static_cast<int>(sizeof(header)) || !corgi::io::is_valid(header)) {
+      MPI_File_close(&fh);
+      throw std::runtime_error("corgi checkpoint: " + fname + " is not a valid checkpoint");
+    }
+
+    bool match = header.dims == D;
+    for(size_t i=0; i<D; i++) match = match && (header.lengths[i] == _lengths[i]);
+    if(!match) {
+      MPI_File_close(&fh);
+      throw std::invalid_argument("corgi checkpoint: grid dimensions do not match " + fname);
+    }
+
+    const uint64_t ncells = num_cells();
+    std::vector<int32_t> owners(ncells);
+    std::vector<double>  work(ncells);
+    std::vector<corgi::io::tile_record> table(ncells);
+
+    std::exception_ptr err;
+    try {
+      read_at_all(fh, header.mpi_grid_offset,   reinterpret_cast<char*>(owners.data()), ncells*sizeof(int32_t));
+      read_at_all(fh, header.work_grid_offset,  reinterpret_cast<char*>(work.data()),   ncells*sizeof(double));
+      read_at_all(fh, header.tile_table_offset, reinterpret_cast<char*>(table.data()),  
+          ncells*sizeof(corgi::io::tile_record));
+
+      // records of existing tiles must sit at their own cid
+      for(uint64_t c=0; c<ncells; c++) {
+        if(table[c].owner < 0) continue;
+
+        bool ok = table[c].cid == c;
+        auto ind = corgi::internals::into_array( id2index(c, _lengths) );
+        for(size_t d=0; d<D; d++) ok = ok && table[c].indices[d] == static_cast<int32_t>(ind[d]);
+        if(!ok) throw std::runtime_error("corgi checkpoint: corrupt tile table in " + fname);
+      }
+    } catch(...) {
+      err = std::current_exception();
+    }
+    agree_on_error(err, fh);
+
+    // re-partition by a prefix sum of the stored work grid (Tile::get_work
+    // as of the last update_work/allgather_work_grid) along cids
+    if(header.num_ranks != comm.size()) {
+
+      // tiles without a work estimate count as the mean of the others
+      double known = 0.0;
+      size_t nknown = 0;
+      for(uint64_t c=0; c<ncells; c++) {
+        if(table[c].owner >= 0 && work[c] > 0.0) {
+          known += work[c];
+          nknown++;
+        }
+      }
+      const double unknown = nknown > 0 ? known/static_cast<double>(nknown) : 1.0;
+
+      auto weight = [&](uint64_t c) { 
+        if(table[c].owner < 0) return 0.0;
+        return work[c] > 0.0 ? work[c] : unknown;
+      };
+
+      double total = 0.0;
+      for(uint64_t c=0; c<ncells; c++) total += weight(c);
+
+      double prefix = 0.0;
+      for(uint64_t c=0; c<ncells; c++) {
+        const double w = weight(c);
+
+        int rank = total > 0.0 ? static_cast<int>( (prefix + 0.5*w)*comm.size()/total ) : 0;
+        owners[c] = std::min(rank, comm.size() - 1);
+        if(table[c].owner >= 0) table[c].owner = owners[c];
+        prefix += w;
+      }
+    }
+
+    // create my tiles
+    tiles.clear();
+    std::array<size_t, D> ind;
+    std::array<double, D> tmins, tmaxs;
+    for(auto& r : table) {
+      if(r.owner != comm.rank()) continue;
+
+      auto tileptr = factory();
+      for(size_t d=0; d<D; d++) {
+        ind[d]   = static_cast<size_t>(r.indices[d]);
+        tmins[d] = r.mins[d];
+        tmaxs[d] = r.maxs[d];
+      }
+      add_tile(tileptr, corgi::internals::into_tuple(ind));
+      tileptr->set_tile_mins(tmins);
+      tileptr->set_tile_maxs(tmaxs);
+      if(r.work > 0.0) tileptr->measured_work = r.work;
+    }
+
+    // payloads
+    const auto local_ids = get_local_tiles(true);
+    std::vector< std::vector<char> > payloads(local_ids.size());
+    std::unordered_map<uint64_t, size_t> slot;
+    try {
+      for(size_t i=0; i<local_ids.size(); i++) {
+        const auto& r = table[ local_ids[i] ];
+        if(r.size > header.file_size || r.offset > header.file_size - r.size) {
+          throw std::runtime_error("corgi checkpoint: corrupt tile table in " + fname);
+        }
+        payloads[i].resize(r.size);
+        read_at(fh, r.offset, payloads[i].data(), r.size);
+        slot[ local_ids[i] ] = i;
+      }
+    } catch(...) {
+      err = std::current_exception();
+    }
+    agree_on_error(err, fh);
+    check_mpi_io( MPI_File_close(&fh), "close");
+
+    for_each_tile_untimed(local_ids, [&payloads, &slot](Tile_t& tile) {
+        auto& p = payloads[ slot.at(tile.cid) ];
+        tile.deserialize(p.data(), p.size());
+    });
+
+    // global grids
+    std::vector<int> owners_int(owners.begin(), owners.end());
+    std::array<size_t, D> lens = _lengths;
+    _mpi_grid.deserialize(owners_int, lens);
+    _work_grid.deserialize(work, lens);
+
+    std::array<double, D> gmins, gmaxs;
+    for(size_t i=0; i<D; i++) { gmins[i] = header.mins[i]; gmaxs[i] = header.maxs[i]; }
+    set_grid_lims(gmins, gmaxs);
+
+    return header.step;
   }
 
 }; // end of Grid class
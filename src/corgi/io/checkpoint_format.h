@@ -0,0 +1,120 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+
+namespace corgi {
+  namespace io {
+
+
+/*! \brief On-disk layout of a grid checkpoint
+ *
+ * A checkpoint is a single binary file:
+ *
+ *  - checkpoint_header
+ *  - int32  mpi_grid[num_cells]     (first index running fastest)
+ *  - double work_grid[num_cells]
+ *  - tile_record tiles[num_cells]   (indexed by cid)
+ *  - tile payloads
+ *
+ * All offsets are absolute byte offsets from the beginning of the file and
+ * all values are in the native byte order of the writer. Missing tiles
+ * have owner = -1 in their record.
+ *
+ * NOTE: this header is plain data only (no MPI) so that the files can be
+ * read by post-processing tools.
+ */
+constexpr char     checkpoint_magic[8] = {'C','O','R','G','I','C','K','P'};
+constexpr uint32_t checkpoint_version  = 1;
+
+/// file header
+struct checkpoint_header {
+  char     magic[8];
+  uint32_t version;
+  uint32_t dims;
+
+  /// grid configuration; unused dimensions are 1 (lengths) and 0 (mins/maxs)
+  uint64_t lengths[3];
+  double   mins[3];
+  double   maxs[3];
+
+  /// total number of cids, i.e., product of lengths
+  uint64_t num_cells;
+
+  /// number of tiles that exist
+  uint64_t num_tiles;
+
+  /// simulation step given by the writer
+  int64_t  step;
+
+  /// number of ranks that wrote the file
+  int32_t  num_ranks;
+  uint32_t reserved;
+
+  /// section offsets
+  uint64_t mpi_grid_offset;
+  uint64_t work_grid_offset;
+  uint64_t tile_table_offset;
+  uint64_t payload_offset;
+
+  /// total size of the file
+  uint64_t file_size;
+};
+
+/// tile metadata and location of its payload
+struct tile_record {
+  uint64_t cid;
+  int32_t  owner;
+  int32_t  indices[3];
+  double   mins[3];
+  double   maxs[3];
+  double   work;   // Tile::measured_work (s); negative if never measured
+  uint64_t offset;
+  uint64_t size;
+};
+
+static_assert(std::is_trivially_copyable<checkpoint_header>::value, "header must be POD");
+static_assert(std::is_trivially_copyable<tile_record>::value,       "tile record must be POD");
+static_assert(sizeof(checkpoint_header) == 160, "unexpected padding in checkpoint_header");
+static_assert(sizeof(tile_record)       == 96,  "unexpected padding in tile_record");
+
+
+/// round offset up to a multiple of alignment
+inline uint64_t align_up(uint64_t offset, uint64_t alignment = 64)
+{
+  return (offset + alignment - 1)/alignment*alignment;
+}
+
+/// initialize header and compute section offsets for the given grid size
+inline checkpoint_header make_header(uint32_t dims, uint64_t num_cells)
+{
+  checkpoint_header h;
+  std::memset(&h, 0, sizeof(h));
+  std::memcpy(h.magic, checkpoint_magic, sizeof(h.magic));
+  h.version   = checkpoint_version;
+  h.dims      = dims;
+  h.num_cells = num_cells;
+  for(int i=0; i<3; i++) h.lengths[i] = 1;
+
+  h.mpi_grid_offset   = align_up( sizeof(checkpoint_header) );
+  h.work_grid_offset  = align_up( h.mpi_grid_offset   + num_cells*sizeof(int32_t) );
+  h.tile_table_offset = align_up( h.work_grid_offset  + num_cells*sizeof(double) );
+  h.payload_offset    = align_up( h.tile_table_offset + num_cells*sizeof(tile_record) );
+  h.file_size         = h.payload_offset;
+
+  return h;
+}
+
+/// check that the header belongs to a checkpoint we can read
+inline bool is_valid(const checkpoint_header& h)
+{
+  return std::memcmp(h.magic, checkpoint_magic, sizeof(h.magic)) == 0 &&
+         h.version == checkpoint_version &&
+         h.dims >= 1 && h.dims <= 3;
+}
+
+
+  } // end of io
+} // end of corgi
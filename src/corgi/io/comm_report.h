@@ -0,0 +1,139 @@
+#pragma once
+
+#include <vector>
+#include <string>
+#include <fstream>
+#include <cstdint>
+#include <stdexcept>
+#include <algorithm>
+
+
+namespace corgi {
+  namespace io {
+
+
+/*! \brief Who sends how much to whom in one communication mode
+ *
+ * Made by Grid::make_comm_report from the boundary analysis, i.e., without
+ * sending anything. A message is one (boundary tile, destination) pair as
+ * in Grid::send_data; bytes are given by Tile::data_size, or by
+ * Tile::packed_size (before encoding) if the mode has a codec, and are 0
+ * for tiles that do not implement them.
+ *
+ * Matrices are ranks x ranks, row-major with the sender as row.
+ */
+struct comm_report {
+
+  int ranks = 0;
+  int mode  = 0;
+
+  std::vector<uint64_t> messages;
+  std::vector<uint64_t> bytes;
+
+  /// per rank: owned tiles, owned tiles with remote neighbors, and halo tiles
+  std::vector<uint64_t> local_tiles;
+  std::vector<uint64_t> boundary_tiles;
+  std::vector<uint64_t> virtual_tiles;
+
+
+  uint64_t get_messages(int from, int to) const { return messages.at(static_cast<size_t>(from)*ranks + to); }
+
+  uint64_t get_bytes(int from, int to) const { return bytes.at(static_cast<size_t>(from)*ranks + to); }
+
+  uint64_t bytes_sent(int r) const
+  {
+    uint64_t n = 0;
+    for(int to=0; to<ranks; to++) n += get_bytes(r, to);
+    return n;
+  }
+
+  uint64_t bytes_recv(int r) const
+  {
+    uint64_t n = 0;
+    for(int from=0; from<ranks; from++) n += get_bytes(from, r);
+    return n;
+  }
+
+  /// number of ranks r sends to
+  int neighbors(int r) const
+  {
+    int n = 0;
+    for(int to=0; to<ranks; to++) n += get_messages(r, to) > 0;
+    return n;
+  }
+
+  /// boundary/local tiles of a rank; 0 for ranks without tiles
+  double surface_to_volume(int r) const
+  {
+    return local_tiles.at(r) > 0 ?
+      static_cast<double>(boundary_tiles[r])/static_cast<double>(local_tiles[r]) : 0.0;
+  }
+
+  /// halo (virtual) tiles per local tile of a rank
+  double halo_to_volume(int r) const
+  {
+    return local_tiles.at(r) > 0 ?
+      static_cast<double>(virtual_tiles[r])/static_cast<double>(local_tiles[r]) : 0.0;
+  }
+
+  uint64_t total_messages() const
+  {
+    uint64_t n = 0;
+    for(auto m : messages) n += m;
+    return n;
+  }
+
+  uint64_t total_bytes() const
+  {
+    uint64_t n = 0;
+    for(auto b : bytes) n += b;
+    return n;
+  }
+
+  /// largest sent+received volume of a rank; bounds the exchange time
+  uint64_t max_rank_bytes() const
+  {
+    uint64_t n = 0;
+    for(int r=0; r<ranks; r++) n = std::max(n, bytes_sent(r) + bytes_recv(r));
+    return n;
+  }
+
+
+  /// Write <prefix>_ranks.csv (one row per rank) and <prefix>_pairs.csv
+  //  (one row per communicating rank pair)
+  void write_csv(const std::string& prefix) const
+  {
+    const std::string fr = prefix + "_ranks.csv";
+    std::ofstream f(fr);
+    if(!f) throw std::runtime_error("corgi: can not open " + fr);
+
+    f << "rank,local_tiles,boundary_tiles,virtual_tiles,surface_to_volume,halo_to_volume,"
+      << "neighbors,messages_sent,bytes_sent,bytes_recv\n";
+    for(int r=0; r<ranks; r++) {
+      uint64_t msgs = 0;
+      for(int to=0; to<ranks; to++) msgs += get_messages(r, to);
+
+      f << r << "," << local_tiles[r] << "," << boundary_tiles[r] << "," << virtual_tiles[r] << ","
+        << surface_to_volume(r) << "," << halo_to_volume(r) << "," << neighbors(r) << ","
+        << msgs << "," << bytes_sent(r) << "," << bytes_recv(r) << "\n";
+    }
+    if(!f) throw std::runtime_error("corgi: can not write " + fr);
+
+    const std::string fp = prefix + "_pairs.csv";
+    std::ofstream g(fp);
+    if(!g) throw std::runtime_error("corgi: can not open " + fp);
+
+    g << "from,to,messages,bytes\n";
+    for(int from=0; from<ranks; from++) {
+      for(int to=0; to<ranks; to++) {
+        if(get_messages(from, to) == 0) continue;
+        g << from << "," << to << "," << get_messages(from, to) << "," << get_bytes(from, to) << "\n";
+      }
+    }
+    if(!g) throw std::runtime_error("corgi: can not write " + fp);
+  }
+};
+
+
+  } // end of io
+} // end of corgi
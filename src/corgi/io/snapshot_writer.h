@@ -0,0 +1,352 @@
+#pragma once
+
+#include <vector>
+#include <algorithm>
+#include <deque>
+#include <string>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <exception>
+#include <stdexcept>
+#include <unordered_map>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <cstdint>
+
+#include "corgi/corgi.h"
+#include "corgi/io/checkpoint_format.h"
+
+
+namespace corgi {
+  namespace io {
+
+
+/*! \brief Asynchronous output of tile payloads
+ *
+ * snapshot() serializes the selected tiles into a staging buffer that
+ * holds a complete checkpoint file (see checkpoint_format.h) as the file
+ * head (header, grids, and tile table) and one slice per tile, and
+ * returns; a background thread then writes the buffer into a per-rank
+ * file while the simulation continues. Tiles are serialized straight into
+ * their slices, so the payloads are copied only once. The last written
+ * buffer is recycled so that in steady state no memory is allocated.
+ *
+ * Memory held by the writer (staged buffers, the recycled buffer, and the
+ * snapshot being staged) is bounded by the budget: tiles are serialized
+ * first and, when the writer falls behind, snapshot() blocks until the new
+ * snapshot fits (back-pressure). A single snapshot larger than the budget
+ * is still accepted once the writer has drained.
+ *
+ * Files are named <prefix>_<step>_<rank>.ckp and contain only the tiles
+ * of that rank. The writer thread never calls MPI.
+ */
+template<std::size_t D>
+class SnapshotWriter
+{
+
+  struct staging_buffer {
+    std::string fname;
+
+    /// header, grids, and tile table (payload_offset bytes)
+    std::vector<char> head;
+
+    /// payload of each tile in file order
+    std::vector<std::vector<char>> tiles;
+
+    size_t size() const
+    {
+      size_t n = head.size();
+      for(auto& t : tiles) n += t.size();
+      return n;
+    }
+
+    size_t capacity() const
+    {
+      size_t n = head.capacity();
+      for(auto& t : tiles) n += t.capacity();
+      return n;
+    }
+  };
+
+  Grid<D>& _grid;
+
+  std::string _prefix;
+
+  /// maximum bytes held by the writer (see held_bytes)
+  size_t _budget;
+
+  std::mutex _mutex;
+  std::condition_variable _cv;
+
+  /// buffers waiting for the writer
+  std::deque<std::unique_ptr<staging_buffer>> _queue;
+
+  /// written buffer ready for reuse (at most one is kept)
+  std::unique_ptr<staging_buffer> _free;
+
+  /// capacity of the buffers in _queue and of the buffer being written
+  size_t _staged_bytes = 0;
+
+  /// buffer currently being written
+  bool _writing = false;
+
+  bool _stop = false;
+
+  /// first error of the writer; re-thrown by snapshot/flush
+  std::exception_ptr _error;
+
+  /// capacity of the buffer that snapshot() is staging
+  size_t _pending_bytes = 0;
+
+  std::thread _thread;
+
+
+  /// total bytes written to disk
+  size_t _bytes_written = 0;
+
+
+  public:
+
+  /// wall-clock time (s) the simulation spent waiting for the writer
+  double stall_time = 0.0;
+
+
+  SnapshotWriter(Grid<D>& grid, std::string prefix, size_t budget = 256*1024*1024) :
+    _grid(grid),
+    _prefix(std::move(prefix)),
+    _budget(budget)
+  {
+    _thread = std::thread([this]() { writer_loop(); });
+  }
+
+  SnapshotWriter(const SnapshotWriter&) = delete;
+  SnapshotWriter& operator=(const SnapshotWriter&) = delete;
+
+  ~SnapshotWriter()
+  {
+    {
+      std::unique_lock<std::mutex> lk(_mutex);
+      _cv.wait(lk, [this]{ return _queue.empty() && !_writing; });
+      _stop = true;
+    }
+    _cv.notify_all();
+    _thread.join();
+  }
+
+
+  /// stage payloads of the given tiles and queue them for writing
+  void snapshot(int64_t step, const std::vector<uint64_t>& cids)
+  {
+    auto buf = acquire();
+    serialize(*buf, cids);
+
+    auto header = _grid.make_checkpoint_header(step);
+    header.num_tiles = cids.size();
+    header.file_size = header.payload_offset;
+    for(auto& t : buf->tiles) header.file_size += t.size();
+
+    buf->fname = _prefix + "_" + std::to_string(step) + "_"
+      + std::to_string(_grid.comm.rank()) + ".ckp";
+    stage(*buf, header, cids);
+
+    enqueue(std::move(buf));
+  }
+
+  /// stage all local tiles
+  void snapshot(int64_t step)
+  {
+    snapshot(step, _grid.get_local_tiles(true));
+  }
+
+  /// block until everything queued so far is on disk
+  void flush()
+  {
+    std::unique_lock<std::mutex> lk(_mutex);
+    _cv.wait(lk, [this]{ return _queue.empty() && !_writing; });
+    rethrow();
+  }
+
+  /// total bytes written to disk so far
+  size_t bytes_written()
+  {
+    std::lock_guard<std::mutex> lk(_mutex);
+    return _bytes_written;
+  }
+
+  /// bytes currently held by staged buffers
+  size_t staged_bytes()
+  {
+    std::lock_guard<std::mutex> lk(_mutex);
+    return _staged_bytes;
+  }
+
+  /// all memory held by the writer: staged, recycled, and pending buffers
+  size_t held_bytes()
+  {
+    std::lock_guard<std::mutex> lk(_mutex);
+    return _staged_bytes + (_free ? _free->capacity() : 0) + _pending_bytes;
+  }
+
+
+  private:
+
+  /// buffer for the next snapshot; the recycled one if there is one
+  std::unique_ptr<staging_buffer> acquire()
+  {
+    std::lock_guard<std::mutex> lk(_mutex);
+    rethrow();
+    return _free ? std::move(_free) : std::make_unique<staging_buffer>();
+  }
+
+  /// serialize tiles into the slices of buf (threaded over tiles)
+  //
+  // Slices keep their capacity between snapshots; extra slices of a
+  // recycled buffer are released.
+  void serialize(staging_buffer& buf, const std::vector<uint64_t>& cids)
+  {
+    buf.tiles.resize(cids.size());
+    std::unordered_map<uint64_t, size_t> slot;
+    for(size_t i=0; i<cids.size(); i++) {
+      slot[ cids[i] ] = i;
+      buf.tiles[i].clear();
+    }
+
+    _grid.for_each_tile_untimed(cids, [&buf, &slot](corgi::Tile<D>& tile) {
+        tile.serialize( buf.tiles[ slot.at(tile.cid) ] );
+    });
+  }
+
+  /// queue buf for the writer; blocks until it fits the budget
+  //
+  // The buffer already exists, so it counts as pending while waiting. A
+  // recycled buffer that would push the writer over the budget is
+  // released instead.
+  void enqueue(std::unique_ptr<staging_buffer> buf)
+  {
+    const size_t size = buf->capacity();
+
+    auto t0 = std::chrono::steady_clock::now();
+    {
+      std::unique_lock<std::mutex> lk(_mutex);
+      _pending_bytes = size;
+      _cv.wait(lk, [this, size]{
+          return _staged_bytes == 0 || _staged_bytes + size <= _budget;
+          });
+      _pending_bytes = 0;
+      rethrow();
+
+      if(_free && _staged_bytes + size + _free->capacity() > _budget) _free.reset();
+      _staged_bytes += size;
+      _queue.push_back(std::move(buf));
+    }
+    _cv.notify_all();
+
+    auto t1 = std::chrono::steady_clock::now();
+    stall_time += std::chrono::duration<double>(t1 - t0).count();
+  }
+
+  /// write the file head (header, grids, and tile table) of buf
+  void stage(staging_buffer& buf, const checkpoint_header& header, const std::vector<uint64_t>& cids)
+  {
+    const uint64_t ncells = header.num_cells;
+
+    // capacity is kept between snapshots
+    buf.head.resize(header.payload_offset);
+    char* out = buf.head.data();
+    std::memset(out, 0, header.payload_offset);
+    std::memcpy(out, &header, sizeof(header));
+
+    auto owners = _grid.py_get_mpi_grid_data();
+    auto work   = _grid.py_get_work_grid_data();
+    for(uint64_t c=0; c<ncells; c++) {
+      int32_t o = owners[c];
+      std::memcpy(out + header.mpi_grid_offset + c*sizeof(int32_t), &o, sizeof(o));
+    }
+    std::memcpy(out + header.work_grid_offset, work.data(), ncells*sizeof(double));
+
+    auto* table = reinterpret_cast<tile_record*>(out + header.tile_table_offset);
+    for(uint64_t c=0; c<ncells; c++) {
+      table[c].cid   = c;
+      table[c].owner = -1;
+    }
+
+    uint64_t offset = header.payload_offset;
+    for(size_t i=0; i<cids.size(); i++) {
+      auto r   = _grid.make_tile_record( _grid.get_tile(cids[i]) );
+      r.offset = offset;
+      r.size   = buf.tiles[i].size();
+      table[r.cid] = r;
+
+      offset += buf.tiles[i].size();
+    }
+  }
+
+  void rethrow()
+  {
+    if(!_error) return;
+    std::exception_ptr err;
+    std::swap(err, _error);
+    std::rethrow_exception(err);
+  }
+
+  void write(const staging_buffer& buf)
+  {
+    // write to a temporary file and move in place once complete
+    const std::string tmp = buf.fname + ".tmp";
+    std::FILE* fp = std::fopen(tmp.c_str(), "wb");
+    if(fp == nullptr) throw std::runtime_error("corgi snapshot: can not open " + tmp);
+
+    bool ok = std::fwrite(buf.head.data(), 1, buf.head.size(), fp) == buf.head.size();
+    for(auto& t : buf.tiles) {
+      if(ok && !t.empty()) ok = std::fwrite(t.data(), 1, t.size(), fp) == t.size();
+    }
+    int err = std::fclose(fp);
+    if(!ok || err != 0) {
+      std::remove(tmp.c_str());
+      throw std::runtime_error("corgi snapshot: failed to write " + tmp);
+    }
+
+    if(std::rename(tmp.c_str(), buf.fname.c_str()) != 0) {
+      throw std::runtime_error("corgi snapshot: can not rename " + tmp);
+    }
+  }
+
+  void writer_loop()
+  {
+    std::unique_lock<std::mutex> lk(_mutex);
+    while(true) {
+      _cv.wait(lk, [this]{ return _stop || !_queue.empty(); });
+      if(_queue.empty()) return; // stopped and drained
+
+      auto buf = std::move(_queue.front());
+      _queue.pop_front();
+      _writing = true;
+      lk.unlock();
+
+      std::exception_ptr err;
+      try {
+        write(*buf);
+      } catch(...) {
+        err = std::current_exception();
+      }
+
+      lk.lock();
+      if(err && !_error) _error = err;
+      if(!err) _bytes_written += buf->size();
+      _staged_bytes -= buf->capacity();
+      _writing = false;
+
+      // keep the larger of the buffers for reuse; the other is released
+      if(!_free || _free->capacity() < buf->capacity()) _free = std::move(buf);
+      _cv.notify_all();
+    }
+  }
+
+};
+
+
+  } // end of io
+} // end of corgi
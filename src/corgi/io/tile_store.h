@@ -0,0 +1,231 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <array>
+#include <stdexcept>
+#include <cstdint>
+#include <cstring>
+#include <cerrno>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "corgi/io/checkpoint_format.h"
+
+
+namespace corgi {
+  namespace io {
+
+
+/// read-only view to one tile of a TileStore; valid while the store is open
+struct tile_view {
+
+  /// metadata (cid, owner, indices, mins, maxs, work)
+  const tile_record* record = nullptr;
+
+  /// payload written by Tile::serialize
+  const char* data = nullptr;
+  size_t size = 0;
+
+  /// payload reinterpreted as an array of T
+  template<typename T>
+  const T* as() const { return reinterpret_cast<const T*>(data); }
+
+  template<typename T>
+  size_t count() const { return size/sizeof(T); }
+};
+
+
+/*! \brief Memory-mapped read-only access to checkpoint files
+ *
+ * Opens files written by Grid::write_checkpoint or SnapshotWriter for
+ * post-processing without MPI and without a grid. The file is mapped,
+ * not read: header, mpi_grid, work_grid and the tile table are accessed
+ * in place and tile payloads are only paged in from disk when touched,
+ * so reading a few tiles costs only their size.
+ *
+ * Dimensionality comes from the file; unused dimensions have length 1.
+ */
+class TileStore
+{
+
+  std::string _fname;
+
+  const char* _map = nullptr;
+  size_t _map_size = 0;
+
+  const checkpoint_header* _header = nullptr;
+  const tile_record* _table = nullptr;
+
+  void close()
+  {
+    if(_map != nullptr) munmap(const_cast<char*>(_map), _map_size);
+    _map = nullptr;
+    _map_size = 0;
+  }
+
+  [[noreturn]] void fail(const std::string& msg)
+  {
+    close();
+    throw std::runtime_error("corgi tile store: " + msg + " " + _fname);
+  }
+
+  /// does an aligned section of num_cells elements at offset lie inside the mapping
+  bool section_fits(uint64_t offset, size_t elem, size_t align) const
+  {
+    return offset % align == 0 && offset <= _map_size
+      && _header->num_cells <= (_map_size - offset)/elem;
+  }
+
+
+  public:
+
+  explicit TileStore(const std::string& fname) : _fname(fname)
+  {
+    int fd = ::open(fname.c_str(), O_RDONLY);
+    if(fd < 0) fail("can not open");
+
+    struct stat st;
+    if(fstat(fd, &st) != 0) { ::close(fd); fail("can not stat"); }
+    _map_size = static_cast<size_t>(st.st_size);
+
+    if(_map_size < sizeof(checkpoint_header)) { ::close(fd); fail("not a checkpoint:"); }
+
+    void* p = mmap(nullptr, _map_size, PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd); // mapping stays valid
+    if(p == MAP_FAILED) { _map_size = 0; fail("can not map"); }
+    _map = static_cast<const char*>(p);
+
+    // access to tiles is sparse; do not read ahead the whole file
+    madvise(p, _map_size, MADV_RANDOM);
+
+    _header = reinterpret_cast<const checkpoint_header*>(_map);
+    if(!is_valid(*_header))               fail("not a checkpoint:");
+    if(_header->file_size > _map_size)    fail("truncated file");
+    if(_header->payload_offset > _map_size) fail("truncated file");
+
+    // sizes and offsets come from the file; check them before any access
+    const auto& h = *_header;
+    uint64_t cells = 1;
+    for(int i=0; i<3; i++) {
+      if(h.lengths[i] == 0 || cells > UINT64_MAX/h.lengths[i]) fail("corrupt grid lengths in");
+      cells *= h.lengths[i];
+    }
+    if(cells != h.num_cells || h.num_tiles > h.num_cells) fail("corrupt grid lengths in");
+
+    if(!section_fits(h.mpi_grid_offset,   sizeof(int32_t),     alignof(int32_t)) ||
+       !section_fits(h.work_grid_offset,  sizeof(double),      alignof(double))  ||
+       !section_fits(h.tile_table_offset, sizeof(tile_record), alignof(tile_record))) {
+      fail("corrupt section offsets in");
+    }
+
+    _table = reinterpret_cast<const tile_record*>(_map + _header->tile_table_offset);
+  }
+
+  TileStore(const TileStore&) = delete;
+  TileStore& operator=(const TileStore&) = delete;
+
+  TileStore(TileStore&& rhs) noexcept :
+    _fname(std::move(rhs._fname)),
+    _map(rhs._map),
+    _map_size(rhs._map_size),
+    _header(rhs._header),
+    _table(rhs._table)
+  {
+    rhs._map = nullptr;
+    rhs._map_size = 0;
+  }
+
+  ~TileStore() { close(); }
+
+
+  //--------------------------------------------------
+  // grid configuration
+
+  const checkpoint_header& header() const { return *_header; }
+
+  size_t dims() const { return _header->dims; }
+
+  int64_t step() const { return _header->step; }
+
+  uint64_t num_cells() const { return _header->num_cells; }
+
+  uint64_t num_tiles() const { return _header->num_tiles; }
+
+  std::array<size_t, 3> lengths() const
+  {
+    return {{ _header->lengths[0], _header->lengths[1], _header->lengths[2] }};
+  }
+
+  std::array<double, 3> mins() const { return {{ _header->mins[0], _header->mins[1], _header->mins[2] }}; }
+  std::array<double, 3> maxs() const { return {{ _header->maxs[0], _header->maxs[1], _header->maxs[2] }}; }
+
+  /// cid of the tile at the given indices (same as Grid::id)
+  uint64_t id(size_t i, size_t j=0, size_t k=0) const
+  {
+    const auto* l = _header->lengths;
+    if(i >= l[0] || j >= l[1] || k >= l[2]) throw std::out_of_range("tile index outside grid");
+    return i + l[0]*j + l[0]*l[1]*k;
+  }
+
+  /// owner ranks; first index running fastest
+  const int32_t* mpi_grid() const
+  {
+    return reinterpret_cast<const int32_t*>(_map + _header->mpi_grid_offset);
+  }
+
+  /// work estimates; first index running fastest
+  const double* work_grid() const
+  {
+    return reinterpret_cast<const double*>(_map + _header->work_grid_offset);
+  }
+
+
+  //--------------------------------------------------
+  // tiles
+
+  /// does the file contain a tile with this cid
+  bool has_tile(uint64_t cid) const
+  {
+    return cid < _header->num_cells && _table[cid].owner >= 0;
+  }
+
+  /// cids of all stored tiles in ascending order
+  std::vector<uint64_t> get_tile_ids() const
+  {
+    std::vector<uint64_t> ret;
+    ret.reserve(_header->num_tiles);
+    for(uint64_t c=0; c<_header->num_cells; c++) {
+      if(_table[c].owner >= 0) ret.push_back(c);
+    }
+    return ret;
+  }
+
+  /// metadata of a stored tile
+  const tile_record& record(uint64_t cid) const
+  {
+    if(!has_tile(cid)) throw std::out_of_range("tile not found in store");
+    return _table[cid];
+  }
+
+  /// lazy view to a stored tile; nothing is read until the data is accessed
+  tile_view get_tile(uint64_t cid) const
+  {
+    const auto& r = record(cid);
+    if(r.offset > _map_size || r.size > _map_size - r.offset) throw std::out_of_range("tile payload outside file");
+
+    tile_view v;
+    v.record = &r;
+    v.data   = _map + r.offset;
+    v.size   = r.size;
+    return v;
+  }
+
+};
+
+
+  } // end of io
+} // end of corgi
@@ -0,0 +1,201 @@
+#pragma once
+
+#include <vector>
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <functional>
+#include <unordered_map>
+#include <tuple>
+#include <thread>
+#include <cassert>
+
+#include "corgi/tile.h"
+#include "corgi/corgi.h"
+
+#include <mpi4cpp/mpi.h>
+
+
+namespace corgi {
+
+
+/*! \brief Dependency-driven time step on top of Grid
+ *
+ * Overlaps the halo exchange of one communication mode with computation.
+ * A step consists of the following tasks:
+ *
+ *  - post receives for all virtual tiles (Grid::recv_data)
+ *  - `pack` every boundary tile and send it (Grid::send_data)
+ *  - `compute_interior` on tiles with no virtual neighbors; these have
+ *    no dependencies and start immediately
+ *  - `unpack` every virtual tile once its messages have arrived
+ *  - `compute_boundary` on a boundary tile once all of its virtual
+ *    neighbors have been unpacked
+ *
+ * Dependencies come from the neighborhoods found by Grid::analyze_boundaries.
+ * The calling thread drives MPI: it polls the incoming messages
+ * (Grid::test_recv) and releases the tasks of each virtual tile to the
+ * worker threads of the grid as soon as its messages have completed, so
+ * one slow neighbor does not hold back the others. Without worker threads
+ * the interior tiles are computed while the messages are in flight and the
+ * rest as they arrive.
+ *
+ * For modes with a codec (Grid::set_codec) the calling thread also decodes
+ * each message into its tile (Tile::unpack_data) before `unpack` is run.
+ *
+ * Any kernel can be left empty. Kernels follow the rules of
+ * Grid::for_each_tile: they must not call MPI nor add/remove tiles. The
+ * compute kernels may read neighboring tiles but must write only to the
+ * tile they are given, and not to the buffers its send_data exposes
+ * (i.e., write into the next time step like Rotator does).
+ */
+template<std::size_t D>
+class StepExecutor
+{
+
+  public:
+
+  using Tile_t   = corgi::Tile<D>;
+  using kernel_t = std::function<void(Tile_t&)>;
+
+  /// grid that the tasks are run on
+  Grid<D>& grid;
+
+  /// prepare boundary tiles for sending
+  kernel_t pack;
+
+  /// consume received data of virtual tiles
+  kernel_t unpack;
+
+  /// advance local tiles with no virtual neighbors
+  kernel_t compute_interior;
+
+  /// advance local tiles next to virtual tiles
+  kernel_t compute_boundary;
+
+  explicit StepExecutor(Grid<D>& grid) : grid(grid) { }
+
+
+  /// run one step exchanging data of the given mode
+  void step(int mode)
+  {
+    grid.recv_data(mode);
+
+    if(pack) grid.for_each_tile_untimed(grid.get_boundary_tiles(), pack);
+    grid.send_data(mode);
+
+    // --------------------------------------------------
+    // build the dependency graph
+    const auto interior = grid.get_interior_tiles();
+    const auto boundary = grid.get_boundary_tiles();
+
+    // virtual tiles that are being received
+    const auto& ranges = grid.recv_data_ranges.at(mode);
+    std::unordered_map<uint64_t, size_t> incoming;
+    for(size_t v=0; v<ranges.size(); v++) incoming[ std::get<0>(ranges[v]) ] = v;
+
+    // virtual tile -> boundary tiles waiting for it
+    std::vector< std::vector<size_t> > dependents(ranges.size());
+    auto deps = std::make_unique< std::atomic<int>[] >(boundary.size());
+
+    for(size_t i=0; i<boundary.size(); i++) {
+      auto vnhood = grid.virtual_nhood(boundary[i]);
+      std::sort(vnhood.begin(), vnhood.end());
+      vnhood.erase( std::unique(vnhood.begin(), vnhood.end()), vnhood.end() );
+
+      int n = 0;
+      for(auto vcid : vnhood) {
+        auto it = incoming.find(vcid);
+        if(it == incoming.end()) continue;
+        dependents[it->second].push_back(i);
+        n++;
+      }
+      deps[i] = n;
+    }
+
+    // --------------------------------------------------
+    // execute
+    auto& pool = grid.pool();
+    const size_t nw = pool.size();
+    size_t next_worker = 0;
+
+    // tasks go to the workers; the calling thread stays in MPI
+    auto schedule = [&](std::function<void()> task) {
+      if(nw == 1) {
+        task();
+      } else {
+        pool.submit(std::move(task), 1 + (next_worker++ % (nw - 1)) );
+      }
+    };
+
+    // only the compute kernels are added to the tile work
+    auto run = [this](const kernel_t& f, Tile_t& tile, bool timed = true) {
+      if(f) grid.call_tile_kernel(tile, f, timed);
+    };
+
+    auto run_boundary = [&](size_t i) {
+      auto& tile = grid.get_tile( boundary[i] );
+      return [&run, this, &tile]() { run(compute_boundary, tile); };
+    };
+
+    grid._in_parallel_region = true;
+    try {
+
+      for(auto cid : interior) {
+        auto& tile = grid.get_tile(cid);
+        schedule([&run, this, &tile]() { run(compute_interior, tile); });
+      }
+
+      for(size_t i=0; i<boundary.size(); i++) {
+        if(deps[i] == 0) schedule( run_boundary(i) );
+      }
+
+      // NOTE: workers submit the boundary tasks they release so the
+      // calling thread can keep polling the messages
+      std::vector<size_t> waiting(ranges.size());
+      for(size_t v=0; v<ranges.size(); v++) waiting[v] = v;
+
+      while(!waiting.empty()) {
+        size_t kept = 0;
+        for(auto v : waiting) {
+          if(!grid.test_recv(mode, v)) {
+            waiting[kept++] = v;
+            continue;
+          }
+
+          auto* tile = &grid.get_tile( std::get<0>(ranges[v]) );
+          schedule([&, v, tile]() {
+            run(unpack, *tile, false);
+            for(auto i : dependents[v]) {
+              if(--deps[i] != 0) continue;
+              if(nw == 1) {
+                run_boundary(i)();
+              } else {
+                pool.submit( run_boundary(i), pool.this_worker() );
+              }
+            }
+          });
+        }
+
+        // nothing arrived; let the workers have the core
+        if(kept == waiting.size()) std::this_thread::yield();
+        waiting.resize(kept);
+      }
+
+      pool.wait();
+
+    } catch(...) {
+      try { pool.wait(); } catch(...) { }
+      grid._in_parallel_region = false;
+      throw;
+    }
+    grid._in_parallel_region = false;
+
+    // recvs are complete; finish sends and clear the message queues
+    grid.wait_data(mode);
+  }
+
+};
+
+
+} // end of corgi namespace
@@ -3,9 +3,12 @@
 
 #include <array>
 #include <vector>
+#include <map>
 #include <tuple>
 #include <iostream>
 #include <algorithm>
+#include <cassert>
+#include <stdexcept>
 
 #include "corgi/common.h"
 #include "corgi/internals.h"
@@ -79,6 +82,24 @@ class Tile
 
     // my virtual owners
     std::vector<int> virtual_owners;
+
+    /// Moore directions of my neighbors grouped by their owner rank
+    //
+    // Set by the grid: for local tiles in analyze_boundaries and for
+    // virtual tiles in recv_data. A boundary tile sending to rank dest
+    // only needs the sides facing halo_directions[dest]; a virtual tile
+    // is read from the sides facing halo_directions[halo_rank].
+    std::map<int, std::vector<corgi::internals::tuple_of<D, int>>> halo_directions;
+
+    /// rank of the grid that set halo_directions (its comm.rank())
+    int halo_rank = 0;
+
+    /// does the tile (or its halo) change; see Grid::exchange_activity
+    //
+    // Inactive local tiles are skipped by Grid::for_each_active_tile, and
+    // after exchange_activity(mode) inactive boundary tiles are not sent
+    // in the next exchange of that mode.
+    bool active = true;
     
     /// coarse mpi_grid grid indices
     corgi::internals::tuple_of<D, size_t> index;
@@ -244,6 +265,60 @@ class Tile
       return reqs;
     }
 
+    /// bytes that send_data of the given mode sends to rank dest
+    //
+    // Only used for the grid message statistics; 0 if not known.
+    virtual size_t data_size(
+        int /*dest*/,
+        int /*mode*/) const
+    {
+      return 0;
+    }
+
+    /// append data of the given mode that is sent to rank dest into buf
+    //
+    // Used instead of send_data/recv_data for modes that the grid encodes
+    // with a codec (see Grid::set_codec); the grid owns the MPI messages.
+    virtual void pack_data(
+        std::vector<char>& /*buf*/,
+        int /*dest*/,
+        int /*mode*/)
+    {
+      throw std::runtime_error("corgi: tile does not implement pack_data");
+    }
+
+    /// append the part of a message that codecs must not touch into buf
+    //
+    // Written before the pack_data payload and always sent as is, e.g.,
+    // element counts that a lossy codec would corrupt. unpack_data gets
+    // the header and the decoded payload back to back. Empty by default.
+    virtual void pack_header(
+        std::vector<char>& /*buf*/,
+        int /*dest*/,
+        int /*mode*/)
+    { }
+
+    /// bytes that pack_header and pack_data of the given mode append for rank dest
+    //
+    // Used instead of data_size for the message statistics of codec modes
+    // (sizes before encoding). Defaults to data_size.
+    virtual size_t packed_size(
+        int dest,
+        int mode) const
+    {
+      return data_size(dest, mode);
+    }
+
+    /// consume data of the given mode from rank orig written by pack_header and pack_data
+    virtual void unpack_data(
+        const char* /*buf*/,
+        size_t /*size*/,
+        int /*orig*/,
+        int /*mode*/)
+    {
+      throw std::runtime_error("corgi: tile does not implement unpack_data");
+    }
+
     /// dummy pairwise Moore neighborhood communication.
     ///
     /// For each local tile A, corgi::Grid::pairwise_moore_communication
@@ -260,6 +335,12 @@ class Tile
     /// is called for all tiles with same direction before proceeding
     /// to the next direction. There is no guarantees on the order of directions
     /// or the order of tiles.
+    ///
+    /// With several grid threads the calls of one direction run concurrently:
+    /// A may only modify itself and B is only read (possibly by other
+    /// threads at the same time). The grid guarantees that B is never
+    /// being modified while A reads it. Pre- and postludes run concurrently
+    /// over the tiles as well.
     virtual void
     pairwise_moore_communication(const Tile& /* other */,
                                  const std::array<int, D> dir_to_other,
@@ -274,13 +355,53 @@ class Tile
     virtual void pairwise_moore_communication_postlude(const int /* mode */) { }
 
 
+    /// wall-clock time (s) spent on this tile in threaded grid loops 
+    // since the last commit_work()
+    double work_timer = 0.0;
+
+    /// moving average of work_timer over commits; negative if never measured
+    double measured_work = -1.0;
+
+    /// add execution time of one tile kernel call
+    void record_work(double seconds)
+    {
+      work_timer += seconds;
+    }
+
+    /// fold accumulated timings into measured_work and reset the timer
+    void commit_work(double alpha = 0.5)
+    {
+      if(work_timer <= 0.0) return;
+
+      measured_work = measured_work < 0.0 ? work_timer 
+        : alpha*work_timer + (1.0 - alpha)*measured_work;
+      work_timer = 0.0;
+    }
+
+    /// estimate used by get_work before the tile has been measured; 
+    // Grid::update_work sets it to the mean measured_work of all ranks so
+    // that timed and untimed tiles are in the same units (seconds)
+    double unmeasured_work = 1.0;
+
     /// Local computational work estimate for this tile
+    //
+    // Defaults to the measured execution time (s) when it is available.
     virtual double get_work()
     {
-      return 1.0;
+      return measured_work > 0.0 ? measured_work : unmeasured_work;
     }
 
 
+    /// append tile payload (user data) into buf for checkpoints
+    //
+    // Metadata (index, limits, owner) is stored by the grid; only the 
+    // data of derived classes needs to go here. Default stores nothing.
+    virtual void serialize(std::vector<char>& /*buf*/) const { }
+
+    /// restore tile payload written by serialize
+    virtual void deserialize(const char* /*buf*/, size_t /*size*/) { }
+
+
 }; // end of Tile class
 
 } // end of namespace corgi
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <cstddef>
+#include <new>
+#include <vector>
+#include <limits>
+
+namespace corgi { namespace tools {
+
+/// \brief Allocator returning memory aligned to Align bytes (cache lines by default)
+//
+// Drop-in for std::allocator, e.g., std::vector<int, aligned_allocator<int>>,
+// so that SIMD kernels can rely on the first element being aligned and
+// buffers do not share cache lines with other data.
+template<typename T, size_t Align = 64>
+struct aligned_allocator
+{
+  static_assert(Align >= alignof(T), "alignment is smaller than that of T");
+  static_assert((Align & (Align - 1)) == 0, "alignment must be a power of two");
+
+  using value_type = T;
+
+  template<typename U>
+  struct rebind { using other = aligned_allocator<U, Align>; };
+
+  aligned_allocator() noexcept = default;
+
+  template<typename U>
+  aligned_allocator(const aligned_allocator<U, Align>&) noexcept {}
+
+  T* allocate(size_t n)
+  {
+    if(n > std::numeric_limits<size_t>::max()/sizeof(T)) throw std::bad_array_new_length();
+    return static_cast<T*>( ::operator new(n*sizeof(T), std::align_val_t(Align)) );
+  }
+
+  void deallocate(T* p, size_t) noexcept
+  {
+    ::operator delete(p, std::align_val_t(Align));
+  }
+
+  template<typename U>
+  bool operator == (const aligned_allocator<U, Align>&) const noexcept { return true; }
+
+  template<typename U>
+  bool operator != (const aligned_allocator<U, Align>&) const noexcept { return false; }
+};
+
+
+/// std::vector with aligned storage
+template<typename T, size_t Align = 64>
+using aligned_vector = std::vector<T, aligned_allocator<T, Align>>;
+
+
+} } // end of namespace corgi::tools
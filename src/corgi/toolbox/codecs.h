@@ -0,0 +1,470 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+#include <cstring>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+#include <type_traits>
+#include <algorithm>
+
+
+namespace corgi {
+  namespace tools {
+
+/*! \brief Codecs for tile message payloads
+ *
+ * A codec turns a raw byte payload (e.g., from Tile::pack_data) into a
+ * smaller encoded message and back. Payloads are interpreted as arrays
+ * of T; trailing bytes that do not fill a whole T are passed as is.
+ * Every encoded message starts with the raw payload size so that decode
+ * needs no other information. The grid only encodes the pack_data
+ * payload; integer headers that must survive a lossy codec go to
+ * Tile::pack_header and are sent raw.
+ *
+ *  - bitpack_codec<T>:      integers stored with the minimum number of
+ *                           bits relative to the smallest value
+ *                           (0/1 meshes become 1 bit per cell)
+ *  - delta_varint_codec<T>: zigzag-coded differences of consecutive
+ *                           integers as LEB128 varints (smooth or sorted data)
+ *  - fixed_rate_codec<T>:   lossy; floats quantized to a fixed number of
+ *                           bits within blocks of 64 values
+ *  - copy_codec:            no compression; only routes a mode through
+ *                           Tile::pack_data/unpack_data, e.g., for tiles
+ *                           whose messages change size with the destination
+ *                           (the payload is not copied)
+ */
+class codec {
+
+  public:
+
+  virtual ~codec() = default;
+
+  /// encode n bytes of in into out (out is overwritten)
+  virtual void encode(const char* in, size_t n, std::vector<char>& out) const = 0;
+
+  /// decode n bytes of encoded message in into out (out is overwritten)
+  virtual void decode(const char* in, size_t n, std::vector<char>& out) const = 0;
+
+  /// does decode(encode(x)) reproduce x exactly
+  virtual bool lossless() const { return true; }
+
+  /// are encode and decode plain copies; the grid then packs into and
+  //  unpacks from the MPI buffers directly
+  virtual bool identity() const { return false; }
+};
+
+
+/// message statistics of one encoded communication mode
+struct codec_stats {
+
+  size_t sent_messages  = 0;
+  size_t recv_messages  = 0;
+
+  /// message bytes before encoding (pack_header + pack_data) and on the wire
+  size_t raw_bytes_sent     = 0;
+  size_t encoded_bytes_sent = 0;
+  size_t raw_bytes_recv     = 0;
+  size_t encoded_bytes_recv = 0;
+
+  /// wall-clock time (s) of pack+encode and decode+unpack
+  double encode_time = 0.0;
+  double decode_time = 0.0;
+
+  /// raw/encoded size of the sent data
+  double ratio() const
+  {
+    return encoded_bytes_sent > 0 ?
+      static_cast<double>(raw_bytes_sent)/static_cast<double>(encoded_bytes_sent) : 1.0;
+  }
+};
+
+
+namespace internal {
+
+/// append bit fields into a byte vector, least significant bit first
+class bit_writer {
+  std::vector<char>& out;
+  uint64_t word = 0;
+  int fill = 0;
+
+  public:
+
+  explicit bit_writer(std::vector<char>& out) : out(out) { }
+
+  void put(uint64_t v, int bits)
+  {
+    while(bits > 0) {
+      const int n = std::min(bits, 64 - fill);
+      const uint64_t mask = n == 64 ? ~uint64_t(0) : (uint64_t(1) << n) - 1;
+      word |= (v & mask) << fill;
+      fill += n;
+      bits -= n;
+      v = n == 64 ? 0 : v >> n;
+
+      if(fill == 64) {
+        const char* p = reinterpret_cast<const char*>(&word);
+        out.insert(out.end(), p, p + sizeof(word));
+        word = 0;
+        fill = 0;
+      }
+    }
+  }
+
+  /// write out the last partial word (whole bytes only)
+  void flush()
+  {
+    const char* p = reinterpret_cast<const char*>(&word);
+    out.insert(out.end(), p, p + (fill + 7)/8);
+    word = 0;
+    fill = 0;
+  }
+};
+
+/// read bit fields written by bit_writer
+class bit_reader {
+  const char* ptr;
+  const char* end;
+  uint64_t word = 0;
+  int left = 0;
+
+  void refill()
+  {
+    word = 0;
+    const size_t n = std::min<size_t>(sizeof(word), end - ptr);
+    if(n == 0) throw std::length_error("corgi codec: truncated message");
+    std::memcpy(&word, ptr, n);
+    ptr += n;
+    left = static_cast<int>(8*n);
+  }
+
+  public:
+
+  bit_reader(const char* ptr, const char* end) : ptr(ptr), end(end) { }
+
+  uint64_t get(int bits)
+  {
+    uint64_t v = 0;
+    int shift = 0;
+    while(bits > 0) {
+      if(left == 0) refill();
+      const int n = std::min(bits, left);
+      const uint64_t mask = n == 64 ? ~uint64_t(0) : (uint64_t(1) << n) - 1;
+      v |= (word & mask) << shift;
+      word = n == 64 ? 0 : word >> n;
+      left  -= n;
+      bits  -= n;
+      shift += n;
+    }
+    return v;
+  }
+
+  /// position after the last (partially) consumed byte
+  const char* position() const { return ptr - left/8; }
+};
+
+template<typename T>
+void put(std::vector<char>& out, const T& v)
+{
+  const char* p = reinterpret_cast<const char*>(&v);
+  out.insert(out.end(), p, p + sizeof(T));
+}
+
+template<typename T>
+T get(const char*& in, const char* end)
+{
+  if(in + sizeof(T) > end) throw std::length_error("corgi codec: truncated message");
+  T v;
+  std::memcpy(&v, in, sizeof(T));
+  in += sizeof(T);
+  return v;
+}
+
+/// number of bits needed to store v
+inline int bit_width(uint64_t v)
+{
+  int n = 0;
+  while(v != 0) { v >>= 1; n++; }
+  return n;
+}
+
+/// copy the bytes that do not fill a whole T
+inline void put_tail(std::vector<char>& out, const char* in, size_t n, size_t size)
+{
+  const size_t tail = n % size;
+  out.insert(out.end(), in + n - tail, in + n);
+}
+
+inline void get_tail(const char* in, const char* end, std::vector<char>& out, size_t n, size_t size)
+{
+  const size_t tail = n % size;
+  if(in + tail > end) throw std::length_error("corgi codec: truncated message");
+  if(tail > 0) std::memcpy(out.data() + n - tail, in, tail);
+}
+
+} // end of internal
+
+
+/// payload sent as is (the message size gives the payload size)
+class copy_codec : public codec {
+
+  public:
+
+  void encode(const char* in, size_t n, std::vector<char>& out) const override
+  {
+    out.assign(in, in + n);
+  }
+
+  void decode(const char* in, size_t n, std::vector<char>& out) const override
+  {
+    out.assign(in, in + n);
+  }
+
+  bool identity() const override { return true; }
+};
+
+
+/// frame-of-reference bit packing of integers
+template<typename T>
+class bitpack_codec : public codec {
+  static_assert(std::is_integral<T>::value, "bitpack_codec needs integers");
+
+  public:
+
+  void encode(const char* in, size_t n, std::vector<char>& out) const override
+  {
+    out.clear();
+    internal::put<uint64_t>(out, n);
+
+    const size_t count = n/sizeof(T);
+    std::vector<T> v(count);
+    if(count > 0) std::memcpy(v.data(), in, count*sizeof(T));
+
+    T vmin = count > 0 ? *std::min_element(v.begin(), v.end()) : T(0);
+    T vmax = count > 0 ? *std::max_element(v.begin(), v.end()) : T(0);
+
+    // differences are taken in unsigned arithmetic (no overflow for signed T)
+    using U = typename std::make_unsigned<T>::type;
+    const int bits = internal::bit_width( static_cast<U>( static_cast<U>(vmax) - static_cast<U>(vmin) ) );
+
+    internal::put<T>(out, vmin);
+    internal::put<uint8_t>(out, static_cast<uint8_t>(bits));
+
+    if(bits > 0) {
+      out.reserve(out.size() + (count*bits + 7)/8 + sizeof(T));
+      internal::bit_writer w(out);
+      for(auto x : v) w.put( static_cast<U>( static_cast<U>(x) - static_cast<U>(vmin) ), bits );
+      w.flush();
+    }
+
+    internal::put_tail(out, in, n, sizeof(T));
+  }
+
+  void decode(const char* in, size_t n, std::vector<char>& out) const override
+  {
+    const char* end = in + n;
+    const auto size = internal::get<uint64_t>(in, end);
+    const T    vmin = internal::get<T>(in, end);
+    const int  bits = internal::get<uint8_t>(in, end);
+
+    out.resize(size);
+    const size_t count = size/sizeof(T);
+
+    using U = typename std::make_unsigned<T>::type;
+    if(bits == 0) {
+      for(size_t i=0; i<count; i++) std::memcpy(out.data() + i*sizeof(T), &vmin, sizeof(T));
+    } else {
+      internal::bit_reader r(in, end);
+      for(size_t i=0; i<count; i++) {
+        T x = static_cast<T>( static_cast<U>( static_cast<U>(vmin) + static_cast<U>(r.get(bits)) ) );
+        std::memcpy(out.data() + i*sizeof(T), &x, sizeof(T));
+      }
+      in = r.position();
+    }
+
+    internal::get_tail(in, end, out, size, sizeof(T));
+  }
+};
+
+
+/// zigzag delta coding of integers into LEB128 varints
+template<typename T>
+class delta_varint_codec : public codec {
+  static_assert(std::is_integral<T>::value, "delta_varint_codec needs integers");
+
+  public:
+
+  void encode(const char* in, size_t n, std::vector<char>& out) const override
+  {
+    out.clear();
+    internal::put<uint64_t>(out, n);
+
+    const size_t count = n/sizeof(T);
+    out.reserve(out.size() + count + 16);
+
+    int64_t prev = 0;
+    for(size_t i=0; i<count; i++) {
+      T x;
+      std::memcpy(&x, in + i*sizeof(T), sizeof(T));
+      const int64_t cur = static_cast<int64_t>(x);
+
+      const uint64_t d  = static_cast<uint64_t>(cur) - static_cast<uint64_t>(prev);
+      uint64_t zz = (d << 1) ^ static_cast<uint64_t>( static_cast<int64_t>(d) >> 63 );
+      prev = cur;
+
+      do {
+        uint8_t byte = zz & 0x7f;
+        zz >>= 7;
+        if(zz != 0) byte |= 0x80;
+        out.push_back(static_cast<char>(byte));
+      } while(zz != 0);
+    }
+
+    internal::put_tail(out, in, n, sizeof(T));
+  }
+
+  void decode(const char* in, size_t n, std::vector<char>& out) const override
+  {
+    const char* end = in + n;
+    const auto size = internal::get<uint64_t>(in, end);
+
+    out.resize(size);
+    const size_t count = size/sizeof(T);
+
+    int64_t prev = 0;
+    for(size_t i=0; i<count; i++) {
+      uint64_t zz = 0;
+      int shift = 0;
+      uint8_t byte;
+      do {
+        if(in == end || shift > 63) throw std::length_error("corgi codec: truncated message");
+        byte = static_cast<uint8_t>(*in++);
+        zz |= static_cast<uint64_t>(byte & 0x7f) << shift;
+        shift += 7;
+      } while(byte & 0x80);
+
+      const uint64_t d = (zz >> 1) ^ (~(zz & 1) + 1);
+      prev = static_cast<int64_t>( static_cast<uint64_t>(prev) + d );
+
+      T x = static_cast<T>(prev);
+      std::memcpy(out.data() + i*sizeof(T), &x, sizeof(T));
+    }
+
+    internal::get_tail(in, end, out, size, sizeof(T));
+  }
+};
+
+
+/// lossy fixed-rate compression of floating point values
+//
+// Values are split into blocks of 64; each block stores its min and max
+// and every value as a bits-wide integer between them. The absolute error
+// is at most (max - min)/(2^bits - 1)/2 within a block. Blocks containing
+// non-finite values are stored raw.
+template<typename T>
+class fixed_rate_codec : public codec {
+  static_assert(std::is_floating_point<T>::value, "fixed_rate_codec needs floats");
+
+  static constexpr size_t block = 64;
+
+  /// bits per value
+  int bits;
+
+  public:
+
+  explicit fixed_rate_codec(int bits = 16) : bits(bits)
+  {
+    if(bits < 1 || bits > 32) throw std::invalid_argument("fixed_rate_codec: bits must be in [1,32]");
+  }
+
+  bool lossless() const override { return false; }
+
+  void encode(const char* in, size_t n, std::vector<char>& out) const override
+  {
+    out.clear();
+    internal::put<uint64_t>(out, n);
+
+    const size_t count = n/sizeof(T);
+    const double levels = static_cast<double>( (uint64_t(1) << bits) - 1 );
+    out.reserve(out.size() + count*bits/8 + (count/block + 1)*(2*sizeof(T) + 9));
+
+    T v[block];
+    for(size_t b=0; b<count; b += block) {
+      const size_t m = std::min(block, count - b);
+      std::memcpy(v, in + b*sizeof(T), m*sizeof(T));
+
+      bool finite = true;
+      T vmin = v[0], vmax = v[0];
+      for(size_t i=0; i<m; i++) {
+        finite = finite && std::isfinite(v[i]);
+        vmin = std::min(vmin, v[i]);
+        vmax = std::max(vmax, v[i]);
+      }
+
+      // range must also be representable
+      finite = finite && std::isfinite(static_cast<double>(vmax) - static_cast<double>(vmin));
+
+      internal::put<uint8_t>(out, finite ? 0 : 1);
+      if(!finite) {
+        const char* p = reinterpret_cast<const char*>(v);
+        out.insert(out.end(), p, p + m*sizeof(T));
+        continue;
+      }
+
+      internal::put<T>(out, vmin);
+      internal::put<T>(out, vmax);
+
+      const double range = static_cast<double>(vmax) - static_cast<double>(vmin);
+      const double scale = range > 0.0 ? levels/range : 0.0;
+
+      internal::bit_writer w(out);
+      for(size_t i=0; i<m; i++) {
+        const double q = std::round( (static_cast<double>(v[i]) - vmin)*scale );
+        w.put( static_cast<uint64_t>( std::min(q, levels) ), bits );
+      }
+      w.flush();
+    }
+
+    internal::put_tail(out, in, n, sizeof(T));
+  }
+
+  void decode(const char* in, size_t n, std::vector<char>& out) const override
+  {
+    const char* end = in + n;
+    const auto size = internal::get<uint64_t>(in, end);
+
+    out.resize(size);
+    const size_t count = size/sizeof(T);
+    const double levels = static_cast<double>( (uint64_t(1) << bits) - 1 );
+
+    for(size_t b=0; b<count; b += block) {
+      const size_t m = std::min(block, count - b);
+      char* dst = out.data() + b*sizeof(T);
+
+      if(internal::get<uint8_t>(in, end) != 0) {
+        if(in + m*sizeof(T) > end) throw std::length_error("corgi codec: truncated message");
+        std::memcpy(dst, in, m*sizeof(T));
+        in += m*sizeof(T);
+        continue;
+      }
+
+      const double vmin  = internal::get<T>(in, end);
+      const double vmax  = internal::get<T>(in, end);
+      const double delta = (vmax - vmin)/levels;
+
+      internal::bit_reader r(in, end);
+      for(size_t i=0; i<m; i++) {
+        T x = static_cast<T>( vmin + static_cast<double>(r.get(bits))*delta );
+        std::memcpy(dst + i*sizeof(T), &x, sizeof(T));
+      }
+      in = r.position();
+    }
+
+    internal::get_tail(in, end, out, size, sizeof(T));
+  }
+};
+
+
+  } // end of tools
+} // end of corgi
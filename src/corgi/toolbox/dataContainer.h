@@ -1,10 +1,19 @@
 #pragma once
 
 #include <vector>
+#include <utility>
+#include <stdexcept>
 
 namespace datarotators {
 
 /// \brief Container for storing multiple time steps of the simulation
+//
+// Holds L buffer objects that are constructed in place (emplace_back)
+// next to each other in a vector; each buffer (e.g., a mesh) still owns
+// its own allocation for the data. Cycling only moves the index, so
+// buffers are never copied nor cleared. Writers of get(1) therefore find
+// the data of L-1 steps ago there and must overwrite every value they
+// need.
 template <class T, size_t L>
 class Rotator {
   std::vector<T> container;
@@ -13,8 +22,21 @@ class Rotator {
 
   size_t current_step = 0;
 
+  // capacity is fixed so that references to the buffers stay valid
+  Rotator() { container.reserve(L); }
+
+  /// construct the next buffer in place
+  template<typename... Args>
+  T& emplace_back(Args&&... args) {
+    if(container.size() >= L) throw std::length_error("Rotator is full");
+    return container.emplace_back( std::forward<Args>(args)... );
+  }
+
   /// method to add data into the container
-  void push_back(T vm) {container.push_back(vm); };
+  void push_back(T vm) { emplace_back( std::move(vm) ); };
+
+  /// number of buffers added
+  size_t size() const { return container.size(); }
 
   /// general index
   inline size_t index(size_t i) const {return (i + current_step) % L ; };
@@ -38,4 +60,4 @@ class Rotator {
 };
 
 
-} // end of namespace 
+} // end of namespace
@@ -0,0 +1,227 @@
+#pragma once
+
+#include <array>
+#include <vector>
+#include <string>
+#include <chrono>
+#include <cstdint>
+
+#include "corgi/toolbox/thread_pool.h"
+#include "corgi/toolbox/trace.h"
+
+
+/// Set to 0 to compile the grid phase timers and counters out
+#ifndef CORGI_INSTRUMENTATION
+#define CORGI_INSTRUMENTATION 1
+#endif
+
+
+namespace corgi {
+  namespace tools {
+
+/// public grid phases that are timed and counted
+enum class phase : size_t {
+  analyze_boundaries = 0,
+  send_tiles,
+  recv_tiles,
+  send_data,
+  recv_data,
+  wait_data,
+  adoption_council,
+  communicate_adoptions,
+  pairwise_moore_communication,
+  exchange_activity,
+  count
+};
+
+inline const char* phase_name(phase p)
+{
+  static const char* names[] = {
+    "analyze_boundaries",
+    "send_tiles",
+    "recv_tiles",
+    "send_data",
+    "recv_data",
+    "wait_data",
+    "adoption_council",
+    "communicate_adoptions",
+    "pairwise_moore_communication",
+    "exchange_activity",
+  };
+  return names[static_cast<size_t>(p)];
+}
+
+
+/// counters of one phase on one rank
+struct phase_counters {
+
+  uint64_t calls    = 0;
+
+  /// wall-clock time (s)
+  double   time     = 0.0;
+
+  /// MPI messages posted (sends and receives)
+  uint64_t messages = 0;
+
+  /// payload bytes of the messages, as far as they are known
+  uint64_t bytes    = 0;
+
+  /// tiles processed
+  uint64_t tiles    = 0;
+};
+
+
+/// min/max/mean of a value over ranks
+struct rank_summary {
+  double min  = 0.0;
+  double max  = 0.0;
+  double mean = 0.0;
+
+  /// max/mean; 1 for perfect balance
+  double imbalance() const { return mean > 0.0 ? max/mean : 1.0; }
+};
+
+/// phase_counters reduced over ranks
+struct phase_summary {
+  std::string name;
+  rank_summary calls, time, messages, bytes, tiles;
+};
+
+
+/*! \brief Per-phase timers and message counters of a grid
+ *
+ * Counters live in a fixed array indexed by phase, so a timed call costs
+ * two clock reads and a few additions. When the trace recorder is
+ * started, timed phases and event() calls are also logged as events.
+ * With CORGI_INSTRUMENTATION=0 all members are no-ops and the optimizer
+ * removes them.
+ *
+ * Only the thread driving MPI may update the counters; event() may be
+ * called from any worker thread of the grid.
+ */
+class phase_timers {
+
+  public:
+
+  static constexpr bool enabled = CORGI_INSTRUMENTATION != 0;
+  static constexpr size_t num_phases = static_cast<size_t>(phase::count);
+
+
+  /// adds the lifetime of the object to the time of a phase
+  class scope {
+    phase_counters* _c = nullptr;
+    trace_recorder* _trace = nullptr;
+    const char* _name = nullptr;
+    std::chrono::steady_clock::time_point _t0;
+
+    public:
+
+    scope(phase_counters* c, trace_recorder* trace, const char* name) : 
+      _c(c), _trace(trace), _name(name)
+    {
+      if constexpr (enabled) _t0 = std::chrono::steady_clock::now();
+    }
+
+    scope(const scope&) = delete;
+    scope& operator=(const scope&) = delete;
+
+    ~scope()
+    {
+      if constexpr (enabled) {
+        auto t1 = std::chrono::steady_clock::now();
+        _c->calls += 1;
+        _c->time  += std::chrono::duration<double>(t1 - _t0).count();
+
+        if(_trace->active()) {
+          _trace->record(thread_pool::this_worker(), _name, 
+              std::chrono::duration<double>(_t0.time_since_epoch()).count(),
+              std::chrono::duration<double>(t1.time_since_epoch()).count());
+        }
+      }
+    }
+  };
+
+
+  private:
+
+  std::array<phase_counters, num_phases> _counters;
+
+  /// sent bytes and messages per destination rank
+  std::vector<uint64_t> _bytes_to;
+  std::vector<uint64_t> _messages_to;
+
+  trace_recorder _trace;
+
+
+  public:
+
+  /// time a phase until the returned object goes out of scope
+  scope time(phase p) 
+  { 
+    return scope( &_counters[static_cast<size_t>(p)], &_trace, phase_name(p) ); 
+  }
+
+  trace_recorder& trace() { return _trace; }
+  const trace_recorder& trace() const { return _trace; }
+
+  /// is the trace recorder on
+  bool tracing() const { return enabled && _trace.active(); }
+
+  /// record a trace event of the calling worker thread (steady clock seconds)
+  void event(const char* name, double begin, double end, int64_t cid = -1, int32_t peer = -1)
+  {
+    if constexpr (enabled) _trace.record(thread_pool::this_worker(), name, begin, end, cid, peer);
+  }
+
+  /// count tiles processed in a phase
+  void tiles(phase p, uint64_t n)
+  {
+    if constexpr (enabled) _counters[static_cast<size_t>(p)].tiles += n;
+  }
+
+  /// count messages of a phase, e.g., receives (bytes 0 if not known)
+  void count(phase p, uint64_t messages, uint64_t bytes = 0)
+  {
+    if constexpr (enabled) {
+      auto& c = _counters[static_cast<size_t>(p)];
+      c.messages += messages;
+      c.bytes    += bytes;
+    }
+  }
+
+  /// count messages sent to dest (bytes 0 if not known)
+  void sent(phase p, int dest, uint64_t messages, uint64_t bytes = 0)
+  {
+    if constexpr (enabled) {
+      count(p, messages, bytes);
+
+      const auto d = static_cast<size_t>(dest);
+      if(d >= _bytes_to.size()) {
+        _bytes_to.resize(d + 1, 0);
+        _messages_to.resize(d + 1, 0);
+      }
+      _bytes_to[d]    += bytes;
+      _messages_to[d] += messages;
+    }
+  }
+
+  const phase_counters& get(phase p) const { return _counters[static_cast<size_t>(p)]; }
+
+  /// sent bytes per destination rank; index is the rank
+  const std::vector<uint64_t>& bytes_to() const { return _bytes_to; }
+
+  /// sent messages per destination rank; index is the rank
+  const std::vector<uint64_t>& messages_to() const { return _messages_to; }
+
+  /// reset counters; the trace is kept
+  void clear()
+  {
+    _counters.fill(phase_counters());
+    _bytes_to.clear();
+    _messages_to.clear();
+  }
+};
+
+
+  } // end of namespace tools
+} // end of namespace corgi
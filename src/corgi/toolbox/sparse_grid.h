@@ -179,7 +179,8 @@ class sparse_grid {
 
   const T& operator()(corgi::internals::tuple_of<D,size_t> ind) const
   {
-    return _data[ ind ];
+    // never inserts; safe for concurrent readers
+    return _data.at( ind );
   }
 
 
@@ -0,0 +1,310 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstdlib>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <numeric>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+
+namespace corgi {
+  namespace tools {
+
+
+/// \brief Work-stealing thread pool for intra-rank tile parallelism
+//
+// Every worker owns a task deque. Workers pop tasks from the front of
+// their own deque and, once it runs dry, steal from the back of the
+// deques of others. The thread calling wait() participates as worker 0,
+// so a pool of size 1 spawns no threads and runs everything inline.
+//
+// Tasks may submit() more tasks but must not wait() for them: the
+// waiting task is itself pending, so wait() throws when called from a
+// task and parallel_for runs serially there.
+//
+// NOTE: tasks must not call MPI; all communication stays on the thread
+// that owns the grid.
+class thread_pool {
+
+  public:
+
+  using task_t = std::function<void()>;
+
+
+  private:
+
+  struct worker_queue {
+    std::mutex mutex;
+    std::deque<task_t> tasks;
+  };
+
+  /// one task deque per worker (index 0 is the calling thread)
+  std::vector<std::unique_ptr<worker_queue>> _queues;
+
+  /// background workers 1...N-1
+  std::vector<std::thread> _threads;
+
+  /// sleeping/waking of idle workers
+  std::mutex _sleep_mutex;
+  std::condition_variable _cv;
+  bool _stop = false;
+
+  /// tasks sitting in the deques
+  std::atomic<size_t> _queued{0};
+
+  /// tasks submitted but not yet finished
+  std::atomic<size_t> _pending{0};
+
+  /// first exception thrown by a task; re-thrown in wait()
+  std::exception_ptr _error;
+  std::mutex _error_mutex;
+
+  /// worker index of the current thread
+  inline static thread_local size_t _this_worker = 0;
+
+  /// is the current thread executing a task
+  inline static thread_local bool _in_task = false;
+
+
+  public:
+
+  /// number of threads to use if nothing else is said;
+  // read from CORGI_NUM_THREADS and defaults to 1 (i.e., serial)
+  static size_t default_size()
+  {
+    const char* env = std::getenv("CORGI_NUM_THREADS");
+    if(env == nullptr) return 1;
+
+    int n = std::atoi(env);
+    if(n <= 0) return static_cast<size_t>( std::thread::hardware_concurrency() );
+    return static_cast<size_t>(n);
+  }
+
+  explicit thread_pool(size_t nthreads = default_size())
+  {
+    if(nthreads == 0) nthreads = 1;
+
+    for(size_t i=0; i<nthreads; i++) {
+      _queues.push_back( std::make_unique<worker_queue>() );
+    }
+
+    for(size_t i=1; i<nthreads; i++) {
+      _threads.emplace_back([this, i]() { worker_loop(i); });
+    }
+  }
+
+  thread_pool(const thread_pool&) = delete;
+  thread_pool& operator=(const thread_pool&) = delete;
+
+  ~thread_pool()
+  {
+    {
+      std::lock_guard<std::mutex> lk(_sleep_mutex);
+      _stop = true;
+    }
+    _cv.notify_all();
+    for(auto& th : _threads) th.join();
+  }
+
+  /// number of workers (including the calling thread)
+  size_t size() const noexcept { return _queues.size(); }
+
+  /// index of the worker that is executing the current task
+  static size_t this_worker() noexcept { return _this_worker; }
+
+
+  /// add task to the deque of worker `hint` (modulo size)
+  void submit(task_t task, size_t hint = 0)
+  {
+    push(std::move(task), hint);
+    notify();
+  }
+
+  /// process tasks until everything submitted so far has finished
+  //
+  // Re-throws the first exception raised by any of the tasks.
+  void wait()
+  {
+    if(_in_task) throw std::logic_error("thread_pool: wait() called from inside a task");
+
+    while(_pending.load() > 0) {
+      if(try_run(_this_worker)) continue;
+
+      std::unique_lock<std::mutex> lk(_sleep_mutex);
+      _cv.wait(lk, [this]{ return _pending.load() == 0 || _queued.load() > 0; });
+    }
+
+    std::exception_ptr err;
+    {
+      std::lock_guard<std::mutex> lk(_error_mutex);
+      std::swap(err, _error);
+    }
+    if(err) std::rethrow_exception(err);
+  }
+
+
+  /// call f(i) for i in [0, n) and block until all are done
+  //
+  // Indices are dealt out to workers in contiguous blocks; idle workers
+  // then steal the remaining indices from the others.
+  template<typename F>
+  void parallel_for(size_t n, F&& f)
+  {
+    // serial fallback; avoid any overhead (and nested waits)
+    if(size() == 1 || n <= 1 || _in_task) {
+      for(size_t i=0; i<n; i++) f(i);
+      return;
+    }
+
+    const size_t nw = size();
+    for(size_t w=0; w<nw; w++) {
+      for(size_t i = w*n/nw; i < (w+1)*n/nw; i++) {
+        push([&f, i]() { f(i); }, w);
+      }
+    }
+    notify();
+    wait();
+  }
+
+
+  /// call f(i) for i in [0, weights.size()) scheduling by work estimate
+  //
+  // Indices are sorted by decreasing weight and dealt out greedily to the
+  // least loaded worker (longest-processing-time first). Runs of light
+  // indices are bundled into chunks of about total/(4*size) work to keep
+  // the per-task overhead small. Owners run their heaviest chunks first
+  // while thieves take the lightest ones from the back.
+  template<typename F>
+  void parallel_for(const std::vector<double>& weights, F&& f)
+  {
+    const size_t n = weights.size();
+    if(size() == 1 || n <= 1 || _in_task) {
+      for(size_t i=0; i<n; i++) f(i);
+      return;
+    }
+
+    std::vector<size_t> order(n);
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(), 
+        [&weights](size_t lhs, size_t rhs) { return weights[lhs] > weights[rhs]; });
+
+    double total = 0.0;
+    for(auto w : weights) total += w > 0.0 ? w : 0.0;
+    const double chunk_work = total/static_cast<double>(4*size());
+
+    std::vector<double> loads(size(), 0.0);
+
+    size_t first = 0;
+    while(first < n) {
+
+      // grow chunk until it carries enough work
+      size_t last = first;
+      double work = 0.0;
+      do {
+        work += weights[ order[last] ] > 0.0 ? weights[ order[last] ] : 0.0;
+        last++;
+      } while(last < n && work < chunk_work);
+
+      // give it to the least loaded worker
+      size_t w = std::distance(loads.begin(), std::min_element(loads.begin(), loads.end()));
+      loads[w] += work;
+
+      push([&f, &order, first, last]() { 
+          for(size_t k=first; k<last; k++) f( order[k] ); 
+          }, w);
+
+      first = last;
+    }
+    notify();
+    wait();
+  }
+
+
+  private:
+
+  void push(task_t task, size_t hint)
+  {
+    auto& q = *_queues[hint % size()];
+
+    // count the task before anyone can steal and finish it; otherwise
+    // _pending can drop to 0 while the submitting task still runs
+    std::lock_guard<std::mutex> lk(q.mutex);
+    _pending++;
+    _queued++;
+    q.tasks.push_back(std::move(task));
+  }
+
+  void notify()
+  {
+    { std::lock_guard<std::mutex> lk(_sleep_mutex); }
+    _cv.notify_all();
+  }
+
+  /// pop from own deque or steal from others; returns false if nothing was found
+  bool try_run(size_t me)
+  {
+    task_t task;
+    const size_t nw = size();
+
+    {
+      auto& q = *_queues[me];
+      std::lock_guard<std::mutex> lk(q.mutex);
+      if(!q.tasks.empty()) {
+        task = std::move(q.tasks.front());
+        q.tasks.pop_front();
+      }
+    }
+
+    for(size_t k=1; !task && k<nw; k++) {
+      auto& q = *_queues[(me + k) % nw];
+      std::lock_guard<std::mutex> lk(q.mutex);
+      if(!q.tasks.empty()) {
+        task = std::move(q.tasks.back());
+        q.tasks.pop_back();
+      }
+    }
+
+    if(!task) return false;
+    _queued--;
+
+    const bool nested = _in_task;
+    _in_task = true;
+    try {
+      task();
+    } catch(...) {
+      std::lock_guard<std::mutex> lk(_error_mutex);
+      if(!_error) _error = std::current_exception();
+    }
+    _in_task = nested;
+
+    if(--_pending == 0) notify();
+    return true;
+  }
+
+  void worker_loop(size_t me)
+  {
+    _this_worker = me;
+
+    while(true) {
+      if(try_run(me)) continue;
+
+      std::unique_lock<std::mutex> lk(_sleep_mutex);
+      _cv.wait(lk, [this]{ return _stop || _queued.load() > 0; });
+      if(_stop) return;
+    }
+  }
+
+};
+
+
+  } // end of tools
+} // end of corgi
@@ -0,0 +1,118 @@
+#pragma once
+
+#include <vector>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+
+
+namespace corgi {
+  namespace tools {
+
+/// one timed interval of a trace
+struct trace_event {
+
+  /// static string; phase name, "tile", ...
+  const char* name = nullptr;
+
+  /// steady clock seconds
+  double begin = 0.0;
+  double end   = 0.0;
+
+  /// tile id or -1
+  int64_t cid  = -1;
+
+  /// remote rank of a message or -1
+  int32_t peer = -1;
+};
+
+
+/*! \brief Event recorder with one ring buffer per worker thread
+ *
+ * Each ring is only written by its own thread (index from
+ * thread_pool::this_worker), so recording takes no locks and no atomics.
+ * When a ring is full the oldest events are overwritten. Rings may only
+ * be read (events()) while no worker threads are running.
+ */
+class trace_recorder {
+
+  struct ring {
+    std::vector<trace_event> events;
+    uint64_t head = 0; // number of events ever recorded
+  };
+
+  std::vector<std::unique_ptr<ring>> _rings;
+  size_t _capacity = 0;
+  bool _active = false;
+
+
+  public:
+
+  static double now()
+  {
+    return std::chrono::duration<double>(
+        std::chrono::steady_clock::now().time_since_epoch() ).count();
+  }
+
+  /// start recording; keeps the last capacity events of each of nthreads threads
+  void start(size_t nthreads, size_t capacity)
+  {
+    _capacity = capacity > 0 ? capacity : 1;
+    _rings.clear();
+    for(size_t t=0; t<nthreads; t++) {
+      _rings.push_back( std::make_unique<ring>() );
+      _rings.back()->events.resize(_capacity);
+    }
+    _active = true;
+  }
+
+  void stop() { _active = false; }
+
+  bool active() const { return _active; }
+
+  size_t num_threads() const { return _rings.size(); }
+
+  /// add an event of thread t (thread_pool::this_worker())
+  void record(size_t t, const char* name, double begin, double end, int64_t cid = -1, int32_t peer = -1)
+  {
+    if(!_active || t >= _rings.size()) return;
+
+    auto& r = *_rings[t];
+    auto& e = r.events[r.head % _capacity];
+    e.name  = name;
+    e.begin = begin;
+    e.end   = end;
+    e.cid   = cid;
+    e.peer  = peer;
+    r.head++;
+  }
+
+  /// events of thread t, oldest first
+  std::vector<trace_event> events(size_t t) const
+  {
+    const auto& r = *_rings.at(t);
+    const uint64_t n = r.head < _capacity ? r.head : _capacity;
+
+    std::vector<trace_event> ret;
+    ret.reserve(n);
+    for(uint64_t i=r.head - n; i<r.head; i++) ret.push_back( r.events[i % _capacity] );
+    return ret;
+  }
+
+  /// events lost to ring overflow
+  uint64_t dropped() const
+  {
+    uint64_t n = 0;
+    for(const auto& r : _rings) n += r->head > _capacity ? r->head - _capacity : 0;
+    return n;
+  }
+
+  void clear()
+  {
+    for(auto& r : _rings) r->head = 0;
+  }
+};
+
+
+  } // end of namespace tools
+} // end of namespace corgi
@@ -18,5 +18,96 @@ std::string Viking::pray_for_odin() { return "Oooh Mighty Odin!"; }
 std::string Swede::fika() { return "---: It is fika time, get the kanelbullas"; }
 std::string Vallhund::bark() { return "ruf ruf ruf"; }
 
+// threaded grid loops
+void corgitest::visit_local_tiles(corgi::Grid<2>& grid)
+{
+  grid.for_each_local_tile([](corgi::Tile<2>& tile) {
+    dynamic_cast<CountingTile&>(tile).visits++;
+  });
+}
+
+void corgitest::step_local_tiles(corgi::Grid<2>& grid, int mode)
+{
+  auto visit = [](corgi::Tile<2>& tile) {
+    dynamic_cast<CountingTile&>(tile).visits++;
+  };
+
+  corgi::StepExecutor<2> executor(grid);
+  executor.compute_interior = visit;
+  executor.compute_boundary = visit;
+  executor.step(mode);
+}
+
+namespace {
+
+/// value of the tile plus the values of its Moore neighbors
+void sum_nhood(corgi::Grid<2>& grid, corgi::Tile<2>& tile)
+{
+  auto& t = dynamic_cast<SumTile&>(tile);
+  t.sum = t.value;
+  for(auto& ind : t.nhood()) {
+    t.sum += dynamic_cast<const SumTile&>( grid.get_tile( grid.id(ind) ) ).value;
+  }
+}
+
+} // end of anonymous namespace
+
+void corgitest::step_sums(corgi::Grid<2>& grid, int mode)
+{
+  auto kernel = [&grid](corgi::Tile<2>& tile) { sum_nhood(grid, tile); };
+
+  corgi::StepExecutor<2> executor(grid);
+  executor.compute_interior = kernel;
+  executor.compute_boundary = kernel;
+  executor.step(mode);
+}
+
+void corgitest::exchange_sums(corgi::Grid<2>& grid, int mode)
+{
+  grid.exchange_data(mode);
+  grid.for_each_local_tile([&grid](corgi::Tile<2>& tile) { sum_nhood(grid, tile); });
+}
+
+void corgitest::exchange_two_modes(corgi::Grid<2>& grid, int raw_mode, int codec_mode)
+{
+  // raw receives are posted first so that they could swallow encoded messages
+  grid.recv_data(raw_mode);
+  grid.send_data(codec_mode);
+  grid.send_data(raw_mode);
+  grid.recv_data(codec_mode);
+  grid.wait_data(raw_mode);
+  grid.wait_data(codec_mode);
+  grid.for_each_local_tile([&grid](corgi::Tile<2>& tile) { sum_nhood(grid, tile); });
+}
+
+// tasks submitting tasks; returns the number of finished tasks once wait() returns
+size_t corgitest::nested_submit(size_t nthreads, size_t ntasks)
+{
+  corgi::tools::thread_pool pool(nthreads);
+  std::atomic<size_t> done{0};
+
+  for(size_t i=0; i<ntasks; i++) {
+    pool.submit([&pool, &done]() {
+      pool.submit([&done]() { done++; }, pool.this_worker());
+
+      // keep the parent busy so that the child gets stolen and finishes first
+      volatile size_t spin = 0;
+      for(size_t k=0; k<10000; k++) spin = spin + k;
+
+      done++;
+    }, i);
+  }
+  pool.wait();
+
+  return done.load();
+}
+
+void corgitest::wait_in_task(size_t nthreads)
+{
+  corgi::tools::thread_pool pool(nthreads);
+  pool.submit([&pool]() { pool.wait(); });
+  pool.wait();
+}
+
 // Grid methods
 //std::string Grid::pet_shop() { return "No Corgis for sale."; }
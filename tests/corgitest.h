@@ -1,9 +1,15 @@
 #pragma once
 
+#include <atomic>
 #include <iostream>
 #include <vector>
+#include <cstring>
+#include <cstdint>
+#include <stdexcept>
 
 #include "corgi/tile.h"
+#include "corgi/corgi.h"
+#include "corgi/step_executor.h"
 
 
 namespace corgitest {
@@ -135,6 +141,81 @@ struct MooreTestTile : public corgi::Tile<2> {
     };
 };
 
+/// Tile that counts how many times a threaded grid loop has visited it
+struct CountingTile : public corgi::Tile<2> {
+
+    int visits = 0;
+
+    ~CountingTile() override = default;
+
+    void serialize(std::vector<char>& buf) const override {
+        const char* p = reinterpret_cast<const char*>(&visits);
+        buf.insert(buf.end(), p, p + sizeof(visits));
+    }
+
+    void deserialize(const char* buf, size_t size) override {
+        if(size == sizeof(visits)) std::memcpy(&visits, buf, sizeof(visits));
+    }
+};
+
+/// Tile that sends one value and sums the values of its Moore neighborhood
+struct SumTile : public corgi::Tile<2> {
+
+    double value = 0.0;
+    double sum   = 0.0;
+
+    ~SumTile() override = default;
+
+    std::vector<mpi4cpp::mpi::request> 
+    send_data(mpi4cpp::mpi::communicator& comm, int dest, int /*mode*/, int tag) override {
+        return { comm.isend(dest, tag, &value, 1) };
+    }
+
+    std::vector<mpi4cpp::mpi::request> 
+    recv_data(mpi4cpp::mpi::communicator& comm, int orig, int /*mode*/, int tag) override {
+        return { comm.irecv(orig, tag, &value, 1) };
+    }
+
+    // packed messages carry the mode so that a mix-up of modes is caught
+    void pack_data(std::vector<char>& buf, int /*dest*/, int mode) override {
+        const int32_t m = mode;
+        const char* p = reinterpret_cast<const char*>(&value);
+        const char* q = reinterpret_cast<const char*>(&m);
+        buf.insert(buf.end(), p, p + sizeof(value));
+        buf.insert(buf.end(), q, q + sizeof(m));
+    }
+
+    void unpack_data(const char* buf, size_t size, int /*orig*/, int mode) override {
+        int32_t m = 0;
+        if(size != sizeof(value) + sizeof(m)) throw std::length_error("SumTile: wrong message size");
+        std::memcpy(&m, buf + sizeof(value), sizeof(m));
+        if(m != mode) throw std::runtime_error("SumTile: message of another mode");
+        std::memcpy(&value, buf, sizeof(value));
+    }
+};
+
+/// visit every local tile once using the grid worker threads
+void visit_local_tiles(corgi::Grid<2>& grid);
+
+/// run one corgi::StepExecutor step that visits every local tile once
+void step_local_tiles(corgi::Grid<2>& grid, int mode);
+
+/// one corgi::StepExecutor step of mode setting SumTile::sum on every local tile
+void step_sums(corgi::Grid<2>& grid, int mode);
+
+/// same as step_sums with Grid::exchange_data and a threaded loop afterwards
+void exchange_sums(corgi::Grid<2>& grid, int mode);
+
+/// exchange_sums with a raw and a codec mode in flight at the same time
+void exchange_two_modes(corgi::Grid<2>& grid, int raw_mode, int codec_mode);
+
+/// submit ntasks tasks that each submit one more; returns the tasks finished when wait() returns
+size_t nested_submit(size_t nthreads, size_t ntasks);
+
+/// call thread_pool::wait() from inside a task (throws)
+void wait_in_task(size_t nthreads);
+
+
 //class Grid : public corgi::Grid<2> {
 //  public:
 //    Grid(size_t nx, size_t ny) : corgi::Grid<2>(nx, ny) { }
@@ -64,6 +64,25 @@ PYBIND11_MODULE(pycorgitest, m) {
       .def_readwrite("prelude_mode", &MTile::prelude_mode)
       .def_readwrite("postlude_mode", &MTile::postlude_mode);
 
+  using CTile = corgitest::CountingTile;
+  py::class_<CTile, corgi::Tile<2>, std::shared_ptr<CTile>>(m, "CountingTile")
+      .def(py::init<>())
+      .def_readwrite("visits", &CTile::visits);
+
+  using STile = corgitest::SumTile;
+  py::class_<STile, corgi::Tile<2>, std::shared_ptr<STile>>(m, "SumTile")
+      .def(py::init<>())
+      .def_readwrite("value", &STile::value)
+      .def_readwrite("sum",   &STile::sum);
+
+  m.def("visit_local_tiles", &corgitest::visit_local_tiles);
+  m.def("step_local_tiles",  &corgitest::step_local_tiles);
+  m.def("step_sums",         &corgitest::step_sums);
+  m.def("exchange_sums",     &corgitest::exchange_sums);
+  m.def("exchange_two_modes", &corgitest::exchange_two_modes);
+  m.def("nested_submit",     &corgitest::nested_submit);
+  m.def("wait_in_task",      &corgitest::wait_in_task);
+
   // --------------------------------------------------
   // Grid bindings
   //py::object corgi_node = (py::object) py::module::import("pycorgi.twoD").attr("Grid");
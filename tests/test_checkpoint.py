@@ -0,0 +1,191 @@
+import unittest
+import itertools
+import os
+import tempfile
+import struct
+
+import pycorgi
+import pycorgi.twoD as corgi2D
+import pycorgitest
+
+class checkpoint(unittest.TestCase):
+
+    Nx, Ny = 6, 5
+
+    def setUp(self):
+        fd, self.fname = tempfile.mkstemp(suffix=".ckp")
+        os.close(fd)
+
+    def tearDown(self):
+        os.remove(self.fname)
+
+    def test_write_read(self):
+        grid = corgi2D.Grid(self.Nx, self.Ny)
+        grid.set_grid_lims(0.0, 6.0, -1.0, 1.0)
+
+        for i, j in itertools.product(range(self.Nx), range(self.Ny)):
+            if (i, j) == (2, 3): continue # leave a hole
+            t = pycorgitest.CountingTile()
+            t.visits = 10*i + j
+            grid.add_tile(t, (i, j))
+
+        grid.write_checkpoint(self.fname, 17)
+
+        grid2 = corgi2D.Grid(self.Nx, self.Ny)
+        step = grid2.read_checkpoint(self.fname, pycorgitest.CountingTile)
+
+        self.assertEqual(step, 17)
+        self.assertEqual(grid2.get_local_tiles(), grid.get_local_tiles())
+        self.assertEqual(grid2.get_ymin(), -1.0)
+
+        for tile_id in grid2.get_local_tiles():
+            tile = grid2.get_tile(tile_id)
+            i, j = tile.index
+            self.assertEqual(tile.visits, 10*i + j, msg=f"At tile {tile.index}")
+            self.assertEqual(grid2.get_mpi_grid(i, j), grid2.rank())
+
+    def test_tile_store(self):
+        grid = corgi2D.Grid(self.Nx, self.Ny)
+        grid.set_grid_lims(0.0, 6.0, -1.0, 1.0)
+        for i, j in itertools.product(range(self.Nx), range(self.Ny)):
+            if (i, j) == (2, 3): continue
+            t = pycorgitest.CountingTile()
+            t.visits = 10*i + j
+            grid.add_tile(t, (i, j))
+        grid.write_checkpoint(self.fname, 5)
+
+        store = pycorgi.TileStore(self.fname)
+        self.assertEqual(store.dims(), 2)
+        self.assertEqual(store.step(), 5)
+        self.assertEqual(store.get_lengths(), [self.Nx, self.Ny])
+        self.assertEqual(store.get_mins(), [0.0, -1.0])
+        self.assertEqual(store.num_tiles(), self.Nx*self.Ny - 1)
+        self.assertFalse(store.has_tile(store.id(2, 3)))
+
+        mpi_grid = store.get_mpi_grid()
+        self.assertEqual(mpi_grid.shape, (self.Nx, self.Ny))
+        self.assertFalse(mpi_grid.flags.writeable)
+
+        for cid in store.get_tile_ids():
+            info = store.get_tile_info(cid)
+            i, j = info["index"]
+            self.assertEqual(store.get_tile(cid, "i4")[0], 10*i + j)
+            self.assertEqual(mpi_grid[i, j], info["owner"])
+
+    def test_snapshot_writer(self):
+        grid = corgi2D.Grid(self.Nx, self.Ny)
+        for i, j in itertools.product(range(self.Nx), range(self.Ny)):
+            t = pycorgitest.CountingTile()
+            t.visits = 10*i + j
+            grid.add_tile(t, (i, j))
+
+        prefix = self.fname[:-4]
+        writer = corgi2D.SnapshotWriter(grid, prefix, 1024)
+        for step in range(3):
+            writer.snapshot(step)
+        writer.flush()
+        self.assertEqual(writer.staged_bytes(), 0)
+
+        # single-rank snapshots are regular checkpoints
+        files = [f"{prefix}_{step}_{grid.rank()}.ckp" for step in range(3)]
+        try:
+            self.assertEqual(writer.bytes_written(), sum(os.path.getsize(f) for f in files))
+
+            grid2 = corgi2D.Grid(self.Nx, self.Ny)
+            step = grid2.read_checkpoint(files[2], pycorgitest.CountingTile)
+            self.assertEqual(step, 2)
+            for tile_id in grid2.get_local_tiles():
+                tile = grid2.get_tile(tile_id)
+                i, j = tile.index
+                self.assertEqual(tile.visits, 10*i + j)
+        finally:
+            for f in files: os.remove(f)
+
+    def test_snapshot_budget(self):
+        grid = corgi2D.Grid(self.Nx, self.Ny)
+        for i, j in itertools.product(range(self.Nx), range(self.Ny)):
+            grid.add_tile(pycorgitest.CountingTile(), (i, j))
+
+        prefix = self.fname[:-4]
+        grid.write_checkpoint(self.fname)
+        budget = 3*os.path.getsize(self.fname)
+
+        # staged, recycled, and pending buffers all count
+        writer = corgi2D.SnapshotWriter(grid, prefix, budget)
+        files = [f"{prefix}_{step}_{grid.rank()}.ckp" for step in range(10)]
+        try:
+            for step in range(10):
+                writer.snapshot(step)
+                self.assertLessEqual(writer.held_bytes(), budget)
+            writer.flush()
+        finally:
+            for f in files:
+                if os.path.exists(f): os.remove(f)
+
+    def test_not_a_checkpoint(self):
+        with open(self.fname, "wb") as f:
+            f.write(b"\0"*512)
+
+        grid = corgi2D.Grid(self.Nx, self.Ny)
+        with self.assertRaises(RuntimeError):
+            grid.read_checkpoint(self.fname)
+
+    def test_truncated(self):
+        grid = corgi2D.Grid(self.Nx, self.Ny)
+        for i, j in itertools.product(range(self.Nx), range(self.Ny)):
+            grid.add_tile(pycorgitest.CountingTile(), (i, j))
+        grid.write_checkpoint(self.fname)
+        size = os.path.getsize(self.fname)
+
+        # cut inside the header and inside the tile table
+        for cut in [100, size//2]:
+            os.truncate(self.fname, cut)
+            grid2 = corgi2D.Grid(self.Nx, self.Ny)
+            with self.assertRaises(RuntimeError):
+                grid2.read_checkpoint(self.fname, pycorgitest.CountingTile)
+
+    def test_corrupt_table(self):
+        grid = corgi2D.Grid(self.Nx, self.Ny)
+        for i, j in itertools.product(range(self.Nx), range(self.Ny)):
+            grid.add_tile(pycorgitest.CountingTile(), (i, j))
+        grid.write_checkpoint(self.fname)
+
+        # tile_table_offset is at byte 136 of the header; indices at 12 of a record
+        with open(self.fname, "r+b") as f:
+            f.seek(136)
+            table, = struct.unpack("<Q", f.read(8))
+            f.seek(table + 96 + 12)
+            f.write(struct.pack("<i", self.Nx))
+
+        grid2 = corgi2D.Grid(self.Nx, self.Ny)
+        with self.assertRaises(RuntimeError):
+            grid2.read_checkpoint(self.fname, pycorgitest.CountingTile)
+
+    def test_tile_store_corrupt(self):
+        grid = corgi2D.Grid(self.Nx, self.Ny)
+        for i, j in itertools.product(range(self.Nx), range(self.Ny)):
+            grid.add_tile(pycorgitest.CountingTile(), (i, j))
+        grid.write_checkpoint(self.fname)
+        with open(self.fname, "rb") as f:
+            orig = f.read()
+
+        def patch(offset, fmt, value):
+            with open(self.fname, "wb") as f:
+                f.write(orig[:offset] + struct.pack(fmt, value) + orig[offset + struct.calcsize(fmt):])
+
+        # num_cells (88), mpi_grid_offset (120), work_grid_offset (128), tile_table_offset (136)
+        for offset, value in [(88, self.Nx*self.Ny + 1), (120, len(orig)), (128, 2**63), (136, len(orig) - 64)]:
+            patch(offset, "<Q", value)
+            with self.assertRaises(RuntimeError):
+                pycorgi.TileStore(self.fname)
+
+        # payload offset of the first record (at 80) that overflows with its size
+        table, = struct.unpack("<Q", orig[136:144])
+        patch(table + 80, "<Q", 2**64 - 8)
+        store = pycorgi.TileStore(self.fname)
+        with self.assertRaises(IndexError):
+            store.get_tile(0, "i4")
+        del store
+
+if __name__ == '__main__':
+    unittest.main()
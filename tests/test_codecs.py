@@ -0,0 +1,134 @@
+import unittest
+
+import numpy as np
+
+import pycorgi
+import pycorgi.twoD as corgi2D
+
+try:
+    import pyprtcls
+except ImportError:
+    pyprtcls = None
+
+class codecs(unittest.TestCase):
+
+    def test_bitpack(self):
+        rng = np.random.default_rng(1)
+        mesh = (rng.random(32*32) < 0.1).astype(np.int32)
+
+        codec = pycorgi.BitpackCodec()
+        msg = codec.encode(mesh)
+        self.assertTrue(codec.lossless())
+        self.assertLess(len(msg), mesh.nbytes/20)
+
+        out = np.frombuffer(codec.decode(msg), dtype=np.int32)
+        np.testing.assert_array_equal(out, mesh)
+
+    def test_delta_varint(self):
+        ids = np.cumsum(np.arange(1000, dtype=np.int64) % 7) - 300
+
+        codec = pycorgi.DeltaVarintCodec()
+        msg = codec.encode(ids)
+        self.assertLess(len(msg), ids.nbytes/4)
+
+        out = np.frombuffer(codec.decode(msg), dtype=np.int64)
+        np.testing.assert_array_equal(out, ids)
+
+    def test_fixed_rate(self):
+        rng = np.random.default_rng(2)
+        x = rng.uniform(-2.0, 3.0, 1000)
+
+        codec = pycorgi.FixedRateCodec(16)
+        msg = codec.encode(x)
+        self.assertFalse(codec.lossless())
+        self.assertLess(len(msg), x.nbytes/3)
+
+        out = np.frombuffer(codec.decode(msg), dtype=np.float64)
+        np.testing.assert_allclose(out, x, rtol=0.0, atol=5.0/(2**16 - 1))
+
+    def test_copy(self):
+        x = np.arange(100, dtype=np.int32)
+
+        codec = pycorgi.CopyCodec()
+        self.assertTrue(codec.identity())
+        self.assertFalse(pycorgi.BitpackCodec().identity())
+        msg = codec.encode(x)
+        self.assertEqual(len(msg), x.nbytes)
+
+        out = np.frombuffer(codec.decode(msg), dtype=np.int32)
+        np.testing.assert_array_equal(out, x)
+
+    def test_grid_codec(self):
+        grid = corgi2D.Grid(4, 4)
+        self.assertIsNone(grid.get_codec(0))
+
+        grid.set_codec(0, pycorgi.BitpackCodec())
+        self.assertIsNotNone(grid.get_codec(0))
+
+        # single rank has no virtual tiles; exchange is a no-op
+        grid.analyze_boundaries()
+        grid.exchange_data(0)
+        stats = grid.get_codec_stats(0)
+        self.assertEqual(stats.sent_messages, 0)
+        self.assertEqual(stats.ratio(), 1.0)
+
+        grid.set_codec(0, None)
+        self.assertIsNone(grid.get_codec(0))
+
+    @unittest.skipIf(pyprtcls is None, "particle example is not built")
+    def test_particle_fixed_rate(self):
+        # rows are split between ranks and every tile sends 3+5 particles
+        # up to the next row; the counts must survive the lossy codec
+        Nx, Ny = 4, 4
+        grid = corgi2D.Grid(Nx, Ny)
+        grid.set_grid_lims(0.0, Nx, 0.0, Ny)
+        rank, size = grid.rank(), grid.size()
+        owner = lambda j: j*size//Ny
+        counts = (3, 5)
+
+        def new_tile(i, j):
+            t = pyprtcls.Tile()
+            for s in range(len(counts)):
+                t.set_container( pyprtcls.ParticleBlock(1, 1, 1) )
+            t.set_tile_mins([i, j])
+            t.set_tile_maxs([i+1, j+1])
+            return t
+
+        for j in range(Ny):
+            for i in range(Nx):
+                grid.set_mpi_grid(i, j, owner(j))
+                if owner(j) == rank:
+                    t = new_tile(i, j)
+                    for s, n in enumerate(counts):
+                        for k in range(n):
+                            t.get_container(s).add_particle([i + 0.1*(k+1), j + 1.5, 0.0], [0.1*k, -0.2, s], 1.0)
+                    grid.add_tile(t, (i,j) )
+        grid.analyze_boundaries()
+        grid.send_tiles()
+        grid.recv_tiles()
+        for cid in grid.get_virtual_tiles():
+            (i,j) = grid.get_tile(cid).index
+            grid.replace_tile(new_tile(i, j), (i,j))
+        grid.analyze_boundaries()
+
+        for cid in grid.get_local_tiles():
+            grid.get_tile(cid).check_outgoing_particles()
+
+        grid.set_codec(0, pycorgi.FixedRateCodec(16))
+        grid.exchange_data(0)
+
+        for cid in grid.get_virtual_tiles():
+            t = grid.get_tile(cid)
+            (i,j) = t.index
+            mine = owner( (j+1) % Ny ) == rank
+            for s, n in enumerate(counts):
+                c = t.get_container(s)
+                self.assertEqual(c.size(), n if mine else 0)
+                if mine:
+                    np.testing.assert_allclose(sorted(c.loc(0)), [i + 0.1*(k+1) for k in range(n)], atol=1e-3)
+                    np.testing.assert_allclose(c.loc(1), j + 1.5, atol=1e-3)
+                    np.testing.assert_allclose(c.wgt(), 1.0, atol=1e-3)
+
+
+if __name__ == '__main__':
+    unittest.main()
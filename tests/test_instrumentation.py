@@ -0,0 +1,103 @@
+import unittest
+import itertools
+import json
+import os
+import tempfile
+
+import pycorgi
+import pycorgi.twoD as corgi2D
+
+@unittest.skipUnless(pycorgi.instrumentation, "built with CORGI_INSTRUMENTATION=0")
+class instrumentation(unittest.TestCase):
+
+    Nx, Ny = 5, 4
+
+    def setUp(self):
+        self.grid = corgi2D.Grid(self.Nx, self.Ny)
+        for i, j in itertools.product(range(self.Nx), range(self.Ny)):
+            self.grid.add_tile(corgi2D.Tile(), (i, j))
+
+    def test_phase_counters(self):
+        for _ in range(3):
+            self.grid.analyze_boundaries()
+
+        stats = self.grid.get_phase_stats()
+        ab = stats["analyze_boundaries"]
+        self.assertEqual(ab.calls, 3)
+        self.assertEqual(ab.tiles, 3*self.Nx*self.Ny)
+        self.assertGreaterEqual(ab.time, 0.0)
+        self.assertEqual(stats["wait_data"].calls, 0)
+
+        self.grid.reset_phase_stats()
+        self.assertEqual(self.grid.get_phase_stats()["analyze_boundaries"].calls, 0)
+
+    def test_reduce(self):
+        self.grid.analyze_boundaries()
+        self.grid.exchange_data(0)
+
+        sums = self.grid.reduce_phase_stats()
+        wait = sums["wait_data"]
+        self.assertEqual(wait.name, "wait_data")
+        self.assertEqual(wait.calls.min, 1)
+        self.assertLessEqual(wait.time.min, wait.time.mean)
+        self.assertLessEqual(wait.time.mean, wait.time.max)
+        self.assertGreaterEqual(wait.time.imbalance(), 1.0)
+
+        # single rank sends nothing
+        self.assertEqual(sums["send_data"].messages.max, 0)
+        self.assertEqual(sum(self.grid.get_bytes_sent_to()), 0)
+
+    def test_trace(self):
+        self.grid.set_num_threads(2)
+        self.grid.start_trace(capacity=16)
+        for _ in range(20):
+            self.grid.analyze_boundaries()
+        self.grid.stop_trace()
+        self.grid.analyze_boundaries()
+
+        fd, fname = tempfile.mkstemp(suffix=".json")
+        os.close(fd)
+        try:
+            self.grid.write_trace(fname)
+            with open(fname) as f:
+                trace = json.load(f)
+        finally:
+            os.remove(fname)
+
+        events = [e for e in trace["traceEvents"] if e["ph"] == "X"]
+        self.assertEqual(len(events), 16) # ring keeps the last events
+        self.assertEqual(trace["otherData"]["dropped_events"], 4)
+        for e in events:
+            self.assertEqual(e["name"], "analyze_boundaries")
+            self.assertEqual(e["pid"], self.grid.rank())
+            self.assertGreaterEqual(e["ts"], 0.0)
+
+
+class comm_report(unittest.TestCase):
+
+    def test_single_rank(self):
+        grid = corgi2D.Grid(4, 3)
+        for i, j in itertools.product(range(4), range(3)):
+            grid.add_tile(corgi2D.Tile(), (i, j))
+        grid.analyze_boundaries()
+
+        rep = grid.make_comm_report(0)
+        self.assertEqual(rep.ranks, 1)
+        self.assertEqual(rep.messages.shape, (1, 1))
+        self.assertEqual(rep.total_messages(), 0)
+        self.assertEqual(rep.local_tiles, [12])
+        self.assertEqual(rep.virtual_tiles, [0])
+        self.assertEqual(rep.surface_to_volume(0), 0.0)
+
+        with tempfile.TemporaryDirectory() as d:
+            prefix = os.path.join(d, "comm")
+            grid.write_comm_report(prefix)
+            with open(prefix + "_ranks.csv") as f:
+                rows = f.read().splitlines()
+            self.assertEqual(len(rows), 2)
+            self.assertTrue(rows[1].startswith("0,12,0,0,"))
+            with open(prefix + "_pairs.csv") as f:
+                self.assertEqual(f.read(), "from,to,messages,bytes\n")
+
+if __name__ == '__main__':
+    unittest.main()
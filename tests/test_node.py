@@ -5,6 +5,8 @@ import unittest
 import numpy as np
 import sys
 import pycorgi.twoD as pycorgi
+from pycorgi import CopyCodec
+import pycorgitest
 
 #sys.path.append('../lib')
 
@@ -85,6 +87,18 @@ class Parallel(unittest.TestCase):
                 val = self.grid.get_mpi_grid(i,j)
                 self.assertEqual(val, self.refGrid[i,j])
 
+        #whole grid at once
+        arr = self.grid.get_mpi_grid_array()
+        self.assertEqual(arr.shape, (self.Nx, self.Ny))
+        self.assertTrue( np.array_equal(arr, self.refGrid) )
+
+    def test_grid_arrays(self):
+        ref = np.arange(self.Nx*self.Ny, dtype=float).reshape(self.Nx, self.Ny)
+        self.grid.set_work_grid_array(ref)
+
+        self.assertEqual(self.grid.get_work_grid(3,7), ref[3,7])
+        self.assertTrue( np.array_equal(self.grid.get_work_grid_array(), ref) )
+
     def test_cid(self):
         for j in range(self.grid.get_Ny()):
             for i in range(self.grid.get_Nx()):
@@ -119,6 +133,126 @@ class Parallel(unittest.TestCase):
             #self.assertEqual(ci, ri)
             #self.assertEqual(cj, rj)
 
+        #and all at once
+        tiles = self.grid.get_tiles(cids)
+        self.assertEqual( [c.cid for c in tiles], cids )
+
+    def test_halo_directions(self):
+        rank  = self.grid.rank()
+        other = rank + 1 # never loaded; only owns the last column
+
+        for j in range(self.grid.get_Ny()):
+            for i in range(self.grid.get_Nx()):
+                self.grid.set_mpi_grid(i, j, other if i == self.Nx-1 else rank)
+
+        c = pycorgi.Tile()
+        self.grid.add_tile(c, (self.Nx-2, 5) ) 
+        self.grid.analyze_boundaries()
+
+        c = self.grid.get_tile( self.grid.id(self.Nx-2, 5) )
+        self.assertEqual( sorted(c.halo_directions.keys()), [rank, other] )
+        self.assertEqual( c.halo_directions[other], [(1,-1), (1,0), (1,1)] )
+        self.assertEqual( len(c.halo_directions[rank]), 5 )
+        self.assertEqual( c.halo_rank, rank )
+
+    def test_activity(self):
+        rank = self.grid.rank()
+        for j in range(self.grid.get_Ny()):
+            for i in range(self.grid.get_Nx()):
+                self.grid.set_mpi_grid(i, j, rank)
+                self.grid.add_tile(pycorgi.Tile(), (i,j) )
+        self.grid.analyze_boundaries()
+        self.assertEqual( len(self.grid.get_active_tiles()), self.Nx*self.Ny )
+
+        for cid in self.grid.get_tile_ids():
+            self.grid.get_tile(cid).active = False
+        self.grid.get_tile( self.grid.id(3, 5) ).active = True
+        self.grid.exchange_activity(0)
+
+        ref = sorted( self.grid.id(3+di, 5+dj) for di in (-1,0,1) for dj in (-1,0,1) )
+        self.assertEqual( self.grid.get_active_tiles(True), ref )
+
+        self.grid.analyze_boundaries()
+        self.assertEqual( len(self.grid.get_active_tiles()), self.Nx*self.Ny )
+
+    def test_activity_exchange(self):
+        # rows are split between ranks; quiet boundary tiles must be
+        # skipped by both the owner and the ranks holding virtual copies
+        grid = self.grid
+        rank, size = grid.rank(), grid.size()
+        owner = lambda j: j*size//self.Ny
+
+        for j in range(self.Ny):
+            for i in range(self.Nx):
+                grid.set_mpi_grid(i, j, owner(j))
+                if owner(j) == rank:
+                    t = pycorgitest.SumTile()
+                    t.value = grid.id(i, j) + 1
+                    grid.add_tile(t, (i,j) )
+        grid.analyze_boundaries()
+        grid.send_tiles()
+        grid.recv_tiles()
+        for cid in grid.get_virtual_tiles():
+            grid.replace_tile(pycorgitest.SumTile(), grid.get_tile(cid).index)
+        grid.analyze_boundaries()
+
+        # codec mode so that the messages are counted
+        grid.set_codec(0, CopyCodec())
+        grid.exchange_data(0)
+
+        # only the first boundary tile of every rank stays active
+        boundary = sorted(grid.get_boundary_tiles())
+        for cid in grid.get_tile_ids():
+            grid.get_tile(cid).active = False
+        if boundary:
+            grid.get_tile(boundary[0]).active = True
+        grid.exchange_activity(0)
+
+        for cid in grid.get_local_tiles():
+            grid.get_tile(cid).value = -(cid + 1)
+
+        virtuals = grid.get_virtual_tiles()
+        nsent = sum(len([r for r in grid.get_tile(cid).halo_directions if r != rank]) for cid in boundary)
+
+        # other modes still send every tile
+        grid.set_codec(1, CopyCodec())
+        grid.reset_codec_stats()
+        grid.exchange_data(1)
+        self.assertEqual( grid.get_codec_stats(1).sent_messages, nsent )
+        self.assertEqual( grid.get_codec_stats(1).recv_messages, len(virtuals) )
+        for cid in virtuals:
+            self.assertEqual( grid.get_tile(cid).value, -(cid + 1) )
+            grid.get_tile(cid).value = cid + 1
+
+        grid.reset_codec_stats()
+        grid.exchange_data(0)
+
+        sent = 0
+        if boundary:
+            sent = len([r for r in grid.get_tile(boundary[0]).halo_directions if r != rank])
+
+        active = [cid for cid in virtuals if grid.get_tile(cid).active]
+
+        stats = grid.get_codec_stats(0)
+        self.assertEqual( stats.sent_messages, sent )
+        self.assertEqual( stats.recv_messages, len(active) )
+
+        # quiet virtual tiles keep the previous value
+        for cid in virtuals:
+            ref = -(cid + 1) if cid in active else cid + 1
+            self.assertEqual( grid.get_tile(cid).value, ref )
+
+        if size > 1:
+            self.assertGreater( len(active), 0 )
+            self.assertGreater( len(virtuals), len(active) )
+
+        # the skip applies once
+        grid.reset_codec_stats()
+        grid.exchange_data(0)
+        self.assertEqual( grid.get_codec_stats(0).sent_messages, nsent )
+        for cid in virtuals:
+            self.assertEqual( grid.get_tile(cid).value, -(cid + 1) )
+
 
 # advanced parallel tests
 class Parallel2(unittest.TestCase):
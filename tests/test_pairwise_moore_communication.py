@@ -7,8 +7,16 @@ import pycorgitest
 class pairwise_moore_communication(unittest.TestCase):
 
     def test_wout_virtual_tiles(self):
-        Nx, Ny = 6, 7
+        self.run_wout_virtual_tiles(6, 7, num_threads=1)
+
+    def test_threaded_wout_virtual_tiles(self):
+        # odd and even lengths exercise both coloring schemes
+        self.run_wout_virtual_tiles(6, 7, num_threads=4)
+        self.run_wout_virtual_tiles(5, 3, num_threads=3)
+
+    def run_wout_virtual_tiles(self, Nx, Ny, num_threads):
         grid = corgi2D.Grid(Nx, Ny)
+        grid.set_num_threads(num_threads)
 
         index_space = itertools.product(range(Nx), range(Ny))
 
@@ -0,0 +1,169 @@
+import unittest
+import itertools
+import os
+import tempfile
+
+import pycorgi
+import pycorgi.twoD as corgi2D
+import pycorgitest
+
+class threaded_tile_loops(unittest.TestCase):
+
+    Nx, Ny = 6, 7
+
+    def setUp(self):
+        self.grid = corgi2D.Grid(self.Nx, self.Ny)
+
+        for i, j in itertools.product(range(self.Nx), range(self.Ny)):
+            t = pycorgitest.CountingTile()
+            self.grid.add_tile(t, (i, j))
+
+    def test_num_threads(self):
+        self.grid.set_num_threads(3)
+        self.assertEqual(self.grid.get_num_threads(), 3)
+
+    def test_every_tile_visited_once(self):
+        self.grid.set_num_threads(4)
+
+        for _ in range(3):
+            pycorgitest.visit_local_tiles(self.grid)
+
+        for tile_id in self.grid.get_local_tiles():
+            tile = self.grid.get_tile(tile_id)
+            self.assertEqual(tile.visits, 3, msg=f"At tile {tile.index}")
+
+    def test_step_executor(self):
+        self.grid.set_num_threads(4)
+        self.grid.analyze_boundaries()
+
+        for mode in range(3):
+            pycorgitest.step_local_tiles(self.grid, mode)
+
+        for tile_id in self.grid.get_local_tiles():
+            tile = self.grid.get_tile(tile_id)
+            self.assertEqual(tile.visits, 3, msg=f"At tile {tile.index}")
+
+    def test_nested_submit(self):
+        # wait() must not return before tasks submitted by other tasks finish
+        for _ in range(20):
+            self.assertEqual(pycorgitest.nested_submit(4, 64), 128)
+
+    def test_wait_in_task(self):
+        with self.assertRaises(RuntimeError):
+            pycorgitest.wait_in_task(2)
+
+    def test_unmeasured_work(self):
+        grid = corgi2D.Grid(self.Nx, self.Ny)
+        for i, j in itertools.product(range(self.Nx), range(self.Ny)):
+            if (i, j) != (0, 0):
+                grid.add_tile(pycorgitest.CountingTile(), (i, j))
+
+        grid.set_work_timing(True)
+        pycorgitest.visit_local_tiles(grid)
+
+        # tile added after the timed loop has no measurement yet
+        grid.add_tile(pycorgitest.CountingTile(), (0, 0))
+        grid.update_work()
+
+        works = [grid.get_tile(cid).measured_work for cid in grid.get_local_tiles()]
+        measured = [w for w in works if w > 0.0]
+        self.assertEqual(len(measured), self.Nx*self.Ny - 1)
+
+        # unmeasured tile falls back to the mean of the measured ones
+        mean = sum(measured)/len(measured)
+        self.assertAlmostEqual(grid.get_tile( grid.id(0, 0) ).get_work(), mean)
+        self.assertAlmostEqual(grid.get_work_grid(0, 0), mean)
+
+    def test_io_untimed(self):
+        grid = corgi2D.Grid(self.Nx, self.Ny)
+        for i, j in itertools.product(range(self.Nx), range(self.Ny)):
+            grid.add_tile(pycorgitest.CountingTile(), (i, j))
+        grid.set_work_timing(True)
+
+        # serialization is not tile work
+        fd, fname = tempfile.mkstemp(suffix=".ckp")
+        os.close(fd)
+        try:
+            grid.write_checkpoint(fname)
+        finally:
+            os.remove(fname)
+        grid.update_work()
+
+        for cid in grid.get_local_tiles():
+            self.assertLess(grid.get_tile(cid).measured_work, 0.0)
+
+    def test_interior_tiles(self):
+        self.grid.analyze_boundaries()
+
+        # single rank owns everything so every tile is an interior tile
+        self.assertEqual(self.grid.get_interior_tiles(), self.grid.get_local_tiles())
+        self.assertEqual(len(self.grid.get_boundary_tiles()), 0)
+
+class step_executor_exchange(unittest.TestCase):
+    """StepExecutor against exchange_data and a serial solve; rows are split over the ranks"""
+
+    Nx, Ny = 6, 5
+
+    def make_grid(self):
+        grid = corgi2D.Grid(self.Nx, self.Ny)
+
+        owner = lambda j: j*grid.size()//self.Ny
+        for i, j in itertools.product(range(self.Nx), range(self.Ny)):
+            grid.set_mpi_grid(i, j, owner(j))
+
+        for i, j in itertools.product(range(self.Nx), range(self.Ny)):
+            if owner(j) == grid.rank():
+                t = pycorgitest.SumTile()
+                t.value = grid.id(i, j) + 1
+                grid.add_tile(t, (i, j))
+
+        grid.analyze_boundaries()
+        grid.send_tiles()
+        grid.recv_tiles()
+
+        # virtual tiles start from 0 so that only received values count
+        for cid in grid.get_virtual_tiles():
+            grid.replace_tile(pycorgitest.SumTile(), grid.get_tile(cid).index)
+        grid.analyze_boundaries()
+
+        return grid
+
+    def serial_sum(self, grid, i, j):
+        return sum( grid.id( (i + di) % self.Nx, (j + dj) % self.Ny ) + 1 
+                   for di, dj in itertools.product([-1, 0, 1], repeat=2) )
+
+    def run_step(self, mode, codec=None):
+        for num_threads in [1, 4]:
+            step = self.make_grid()
+            ref  = self.make_grid()
+            for grid in [step, ref]:
+                grid.set_num_threads(num_threads)
+                if codec is not None:
+                    grid.set_codec(mode, codec)
+
+            pycorgitest.step_sums(step, mode)
+            pycorgitest.exchange_sums(ref, mode)
+
+            for cid in step.get_local_tiles():
+                i, j = step.get_tile(cid).index
+                self.assertEqual(ref.get_tile(cid).sum,  self.serial_sum(step, i, j))
+                self.assertEqual(step.get_tile(cid).sum, self.serial_sum(step, i, j), msg=f"At tile {(i, j)}")
+
+    def test_raw(self):
+        self.run_step(0)
+
+    def test_codec(self):
+        self.run_step(1, pycorgi.CopyCodec())
+
+    def test_raw_and_codec(self):
+        grid = self.make_grid()
+        grid.set_codec(1, pycorgi.CopyCodec())
+        pycorgitest.exchange_two_modes(grid, 0, 1)
+
+        for cid in grid.get_local_tiles():
+            i, j = grid.get_tile(cid).index
+            self.assertEqual(grid.get_tile(cid).sum, self.serial_sum(grid, i, j), msg=f"At tile {(i, j)}")
+
+
+if __name__ == '__main__':
+    unittest.main()